@@ -0,0 +1,430 @@
+// Benchmarks for llsd_modern over documents from llsd_modern_corpus.hpp. Not
+// part of the test suite: build optimized and run by hand, e.g.
+//   g++ -O2 bench.cpp -o bench -isystem . -std=c++17 -pthread && ./bench
+//
+// Options:
+//   --json          print one JSON object per result instead of a table
+//   --perf          add hardware counters per node (Linux perf_event_open)
+//   --filter TEXT   only run benchmarks whose name contains TEXT
+//   --min-time SEC  measure each benchmark for at least SEC seconds (0.5)
+#include "llsd_modern.hpp"
+#include "llsd_modern_parallel.hpp"
+#include "llsd_modern_corpus.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <new>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// Every allocation in the process is counted, so each benchmark can report
+// how many it made. Each form of operator new calls the helpers directly
+// rather than another operator new, and each has its matching delete, so the
+// replacements stay consistent for the compiler's new/delete pairing checks.
+static std::atomic<std::uint64_t> g_allocations{0};
+
+static void* counted_alloc(std::size_t size, std::size_t align = 0) noexcept {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (size == 0) size = 1;
+    if (align <= alignof(std::max_align_t)) return std::malloc(size);
+    return std::aligned_alloc(align, (size + align - 1) / align * align);
+}
+
+static void* counted_alloc_or_throw(std::size_t size, std::size_t align = 0) {
+    if (void* p = counted_alloc(size, align)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size) { return counted_alloc_or_throw(size); }
+void* operator new[](std::size_t size) { return counted_alloc_or_throw(size); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return counted_alloc(size); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return counted_alloc(size); }
+void* operator new(std::size_t size, std::align_val_t al) {
+    return counted_alloc_or_throw(size, static_cast<std::size_t>(al));
+}
+void* operator new[](std::size_t size, std::align_val_t al) {
+    return counted_alloc_or_throw(size, static_cast<std::size_t>(al));
+}
+void* operator new(std::size_t size, std::align_val_t al, const std::nothrow_t&) noexcept {
+    return counted_alloc(size, static_cast<std::size_t>(al));
+}
+void* operator new[](std::size_t size, std::align_val_t al, const std::nothrow_t&) noexcept {
+    return counted_alloc(size, static_cast<std::size_t>(al));
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept { std::free(p); }
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double seconds_since(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// Hardware counters for the calling thread, read as one group. Silently
+// unavailable where the kernel or its perf_event_paranoid setting refuses.
+class PerfCounters {
+public:
+    static constexpr int kCount = 4;
+    static constexpr const char* kNames[kCount] = {"cycles", "instructions", "cache_misses", "branch_misses"};
+
+    PerfCounters() {
+#if defined(__linux__)
+        const std::uint64_t configs[kCount] = {PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+                                               PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES};
+        for (int i = 0; i < kCount; ++i) {
+            perf_event_attr attr;
+            std::memset(&attr, 0, sizeof attr);
+            attr.size = sizeof attr;
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = configs[i];
+            attr.disabled = i == 0;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_GROUP;
+            fds_[i] = static_cast<int>(::syscall(SYS_perf_event_open, &attr, 0, -1, i == 0 ? -1 : fds_[0], 0));
+            if (fds_[i] < 0) {
+                close_all();
+                return;
+            }
+        }
+#endif
+    }
+    ~PerfCounters() { close_all(); }
+
+    bool available() const { return fds_[0] >= 0; }
+
+    void start() {
+#if defined(__linux__)
+        if (!available()) return;
+        ::ioctl(fds_[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ::ioctl(fds_[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+#endif
+    }
+
+    // Adds the counts since start() to `totals`
+    void stop(std::uint64_t (&totals)[kCount]) {
+#if defined(__linux__)
+        if (!available()) return;
+        ::ioctl(fds_[0], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+        std::uint64_t values[1 + kCount];
+        if (::read(fds_[0], values, sizeof values) != static_cast<ssize_t>(sizeof values)) return;
+        for (int i = 0; i < kCount; ++i) totals[i] += values[1 + i];
+#else
+        (void)totals;
+#endif
+    }
+
+private:
+    void close_all() {
+#if defined(__linux__)
+        for (int& fd : fds_) {
+            if (fd >= 0) ::close(fd);
+            fd = -1;
+        }
+#endif
+    }
+
+    int fds_[kCount] = {-1, -1, -1, -1};
+};
+
+struct Options {
+    bool json = false;
+    bool perf = false;
+    std::string filter;
+    double min_time = 0.5;
+};
+
+struct Result {
+    std::string name;
+    std::size_t bytes = 0;  // input or output size of one run
+    std::size_t nodes = 0;  // Values in the document
+    std::vector<double> ns; // one entry per run
+    std::uint64_t allocations = 0;
+    std::uint64_t counters[PerfCounters::kCount] = {};
+    bool has_counters = false;
+};
+
+double percentile(std::vector<double> sorted, double p) {
+    std::sort(sorted.begin(), sorted.end());
+    return sorted[std::min(sorted.size() - 1, static_cast<std::size_t>(p * sorted.size()))];
+}
+
+void report(const Result& r, const Options& options) {
+    double mean = 0;
+    for (double ns : r.ns) mean += ns;
+    mean /= r.ns.size();
+    const double runs = static_cast<double>(r.ns.size());
+    const double mb_per_s = r.bytes / mean * 1e3;
+    const double ns_per_node = mean / r.nodes;
+    const double allocs_per_node = r.allocations / runs / r.nodes;
+    if (options.json) {
+        // The library formats its own results
+        auto map = std::make_unique<llsd_modern::Map>();
+        (*map)["name"] = llsd_modern::Value(r.name);
+        (*map)["runs"] = llsd_modern::Value(static_cast<std::int32_t>(r.ns.size()));
+        (*map)["bytes"] = llsd_modern::Value(static_cast<double>(r.bytes));
+        (*map)["nodes"] = llsd_modern::Value(static_cast<double>(r.nodes));
+        (*map)["mb_per_s"] = llsd_modern::Value(mb_per_s);
+        (*map)["ns_per_node"] = llsd_modern::Value(ns_per_node);
+        (*map)["allocs_per_node"] = llsd_modern::Value(allocs_per_node);
+        (*map)["ns_mean"] = llsd_modern::Value(mean);
+        (*map)["ns_p50"] = llsd_modern::Value(percentile(r.ns, 0.5));
+        (*map)["ns_p99"] = llsd_modern::Value(percentile(r.ns, 0.99));
+        if (r.has_counters) {
+            for (int i = 0; i < PerfCounters::kCount; ++i) {
+                (*map)[std::string(PerfCounters::kNames[i]) + "_per_node"] =
+                    llsd_modern::Value(r.counters[i] / runs / r.nodes);
+            }
+        }
+        std::printf("%s\n", llsd_modern::format_json(llsd_modern::Value(std::move(map))).c_str());
+        return;
+    }
+    std::printf("%-30s %9.1f MB/s %8.2f ns/node %6.3f allocs/node  p50 %10.0f ns  p99 %10.0f ns",
+                r.name.c_str(), mb_per_s, ns_per_node, allocs_per_node, percentile(r.ns, 0.5), percentile(r.ns, 0.99));
+    if (r.has_counters) {
+        std::printf("  %6.1f cyc/node %6.1f ins/node", r.counters[0] / runs / r.nodes, r.counters[1] / runs / r.nodes);
+    }
+    std::printf("\n");
+    std::fflush(stdout);
+}
+
+// Runs `setup()` untimed and then `op()` timed, repeatedly for at least
+// options.min_time (and 5 runs), and reports the result
+void measure(const Options& options, const std::string& name, std::size_t bytes, std::size_t nodes,
+             const std::function<void()>& setup, const std::function<void()>& op) {
+    if (!options.filter.empty() && name.find(options.filter) == std::string::npos) return;
+    Result r;
+    r.name = name;
+    r.bytes = bytes;
+    r.nodes = std::max<std::size_t>(1, nodes);
+    PerfCounters perf;
+    r.has_counters = options.perf && perf.available();
+    setup();
+    op(); // warm up
+    auto started = Clock::now();
+    while (r.ns.size() < 5 || seconds_since(started) < options.min_time) {
+        setup();
+        std::uint64_t allocations = g_allocations.load(std::memory_order_relaxed);
+        if (r.has_counters) perf.start();
+        auto start = Clock::now();
+        op();
+        r.ns.push_back(seconds_since(start) * 1e9);
+        if (r.has_counters) perf.stop(r.counters);
+        r.allocations += g_allocations.load(std::memory_order_relaxed) - allocations;
+    }
+    report(r, options);
+}
+
+std::size_t count_nodes(const llsd_modern::Value& v) {
+    std::size_t count = 1;
+    if (auto array = std::get_if<std::unique_ptr<llsd_modern::Array>>(&v.data); array && *array) {
+        for (const auto& item : **array) count += count_nodes(item);
+    } else if (auto map = std::get_if<std::unique_ptr<llsd_modern::Map>>(&v.data); map && *map) {
+        for (const auto& entry : **map) count += count_nodes(entry.second);
+    }
+    return count;
+}
+
+// A document of `kind` from a fixed seed, so every run measures the same input
+llsd_modern::Value make_document(llsd_modern::CorpusKind kind, std::size_t scale) {
+    llsd_modern::CorpusOptions corpus;
+    corpus.scale = scale;
+    return llsd_modern::CorpusGenerator(corpus).generate(kind);
+}
+
+std::string to_binary(const llsd_modern::Value& v) {
+    std::ostringstream out(std::ios::out | std::ios::binary);
+    llsd_modern::format_binary(out, v);
+    return std::move(out).str();
+}
+
+// Codec and tree operations on one document
+void bench_document(const Options& options, const std::string& label, const llsd_modern::Value& doc) {
+    const std::size_t nodes = count_nodes(doc);
+    const std::string binary = to_binary(doc);
+    const std::string json = llsd_modern::format_json(doc);
+    auto nothing = [] {};
+
+    measure(options, "parse_binary/" + label, binary.size(), nodes, nothing, [&] {
+        llsd_modern::detail::ViewStreambuf buf(binary);
+        std::istream in(&buf);
+        llsd_modern::Value v = llsd_modern::parse_binary(in);
+    });
+    std::string out;
+    measure(options, "format_binary/" + label, binary.size(), nodes, nothing, [&] { out = to_binary(doc); });
+    measure(options, "parse_json/" + label, json.size(), nodes, nothing, [&] {
+        llsd_modern::Value v = llsd_modern::parse_json(json);
+    });
+    measure(options, "format_json/" + label, json.size(), nodes, nothing, [&] { out = llsd_modern::format_json(doc); });
+    llsd_modern::Value copy;
+    measure(options, "copy/" + label, binary.size(), nodes, [&] { copy = llsd_modern::Value(); },
+            [&] { copy = llsd_modern::Value(doc); });
+    measure(options, "destroy/" + label, binary.size(), nodes, [&] { copy = llsd_modern::Value(doc); },
+            [&] { copy = llsd_modern::Value(); });
+    std::size_t hash = 0;
+    measure(options, "hash/" + label, binary.size(), nodes, nothing, [&] { hash ^= doc.hash(); });
+
+    // Parallel variants fall back to the sequential walk on small trees
+    static llsd_modern::ThreadPool pool;
+    measure(options, "parallel_copy/" + label, binary.size(), nodes, [&] { copy = llsd_modern::Value(); },
+            [&] { copy = llsd_modern::parallel_copy(doc, pool); });
+    measure(options, "parallel_hash/" + label, binary.size(), nodes, nothing,
+            [&] { hash ^= llsd_modern::parallel_hash(doc, pool); });
+}
+
+// Bounded queue of single items behind a mutex and two condition variables:
+// the usual way to glue pipeline stages, as a baseline for the rings
+template<typename T>
+class MutexQueue {
+public:
+    explicit MutexQueue(std::size_t capacity) : capacity_(capacity) {}
+
+    void push(T v) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_full_.wait(lock, [&] { return items_.size() < capacity_; });
+        items_.push_back(std::move(v));
+        not_empty_.notify_one();
+    }
+
+    // Returns false once closed and drained
+    bool pop(T& out) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_empty_.wait(lock, [&] { return !items_.empty() || closed_; });
+        if (items_.empty()) return false;
+        out = std::move(items_.front());
+        items_.pop_front();
+        not_full_.notify_one();
+        return true;
+    }
+
+    void close() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closed_ = true;
+        not_empty_.notify_all();
+    }
+
+private:
+    std::size_t capacity_;
+    std::deque<T> items_;
+    std::mutex mutex_;
+    std::condition_variable not_full_, not_empty_;
+    bool closed_ = false;
+};
+
+// Same stages as run_binary_pipeline, one document per hop through mutex
+// queues, with a single transform thread so output order is kept
+template<typename Transform>
+void run_mutex_pipeline(std::istream& in, std::ostream& out, Transform transform) {
+    MutexQueue<llsd_modern::Value> decoded(4096), transformed(4096);
+    std::thread decoder([&] {
+        while (in.peek() != std::char_traits<char>::eof()) decoded.push(llsd_modern::parse_binary(in));
+        decoded.close();
+    });
+    std::thread worker([&] {
+        llsd_modern::Value v;
+        while (decoded.pop(v)) {
+            transform(v);
+            transformed.push(std::move(v));
+        }
+        transformed.close();
+    });
+    llsd_modern::Value v;
+    while (transformed.pop(v)) llsd_modern::format_binary(out, v);
+    decoder.join();
+    worker.join();
+}
+
+void bench_pipeline(const Options& options) {
+    llsd_modern::CorpusOptions corpus;
+    corpus.scale = 4;
+    llsd_modern::CorpusGenerator generator(corpus);
+    std::string docs;
+    std::size_t nodes = 0;
+    for (int i = 0; i < 20000; ++i) {
+        llsd_modern::Value message = generator.generate(llsd_modern::CorpusKind::EventQueue);
+        docs += to_binary(message);
+        nodes += count_nodes(message);
+    }
+    auto transform = [](llsd_modern::Value& v) {
+        auto& map = *std::get<std::unique_ptr<llsd_modern::Map>>(v.data);
+        map["handled"] = llsd_modern::Value(true);
+    };
+    std::string result;
+    measure(options, "pipeline/mutex-queue", docs.size(), nodes, [] {}, [&] {
+        std::istringstream in(docs, std::ios::in | std::ios::binary);
+        std::ostringstream out(std::ios::out | std::ios::binary);
+        run_mutex_pipeline(in, out, transform);
+        result = std::move(out).str();
+    });
+    for (std::size_t workers : {1, 2, 4}) {
+        measure(options, "pipeline/rings-x" + std::to_string(workers), docs.size(), nodes, [] {}, [&] {
+            std::istringstream in(docs, std::ios::in | std::ios::binary);
+            std::ostringstream out(std::ios::out | std::ios::binary);
+            llsd_modern::PipelineOptions pipeline;
+            pipeline.workers = workers;
+            llsd_modern::run_binary_pipeline(in, out, transform, pipeline);
+            result = std::move(out).str();
+        });
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--json") {
+            options.json = true;
+        } else if (arg == "--perf") {
+            options.perf = true;
+        } else if (arg == "--filter" && i + 1 < argc) {
+            options.filter = argv[++i];
+        } else if (arg == "--min-time" && i + 1 < argc) {
+            options.min_time = std::atof(argv[++i]);
+        } else {
+            std::fprintf(stderr, "usage: %s [--json] [--perf] [--filter TEXT] [--min-time SEC]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (options.perf && !PerfCounters().available()) {
+        std::fprintf(stderr, "perf_event_open unavailable; reporting without hardware counters\n");
+    }
+
+    bench_document(options, "small", make_document(llsd_modern::CorpusKind::EventQueue, 2));
+    bench_document(options, "medium", make_document(llsd_modern::CorpusKind::InventoryTree, 24));
+    bench_document(options, "config", make_document(llsd_modern::CorpusKind::NestedConfig, 32));
+    bench_document(options, "huge", make_document(llsd_modern::CorpusKind::ObjectProperties, 100000));
+    bench_pipeline(options);
+    return 0;
+}
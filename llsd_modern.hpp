@@ -38,19 +38,75 @@
 #pragma once
 
 #include "nlohmann/json.hpp"
+#include <algorithm>
 #include <array>
+#include <atomic>
+#include <cctype>
+#include <charconv>
 #include <chrono>
+#include <cmath>
 #include <ctime>
 #include <cstdint>
-#include <iomanip>
+#include <cstring>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <limits>
 #include <map>
 #include <memory>
+#include <new>
+#include <optional>
 #include <sstream>
 #include <string>
+#include <string_view>
+#include <tuple>
+#include <stdexcept>
 #include <type_traits>
+#include <unordered_map>
+#include <utility>
 #include <variant>
 #include <vector>
-#include <regex>
+
+#ifndef LLSD_MODERN_HAS_SSE2
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LLSD_MODERN_HAS_SSE2 1
+#else
+#define LLSD_MODERN_HAS_SSE2 0
+#endif
+#endif
+#if LLSD_MODERN_HAS_SSE2
+#include <emmintrin.h>
+#endif
+
+// Arrays of up to this many Values, and maps of up to this many entries, are
+// stored inline without allocating beyond the container itself. Maps of up to
+// LLSD_MODERN_MAP_FLAT entries keep them in one sorted vector.
+#ifndef LLSD_MODERN_ARRAY_INLINE
+#define LLSD_MODERN_ARRAY_INLINE 4
+#endif
+#ifndef LLSD_MODERN_MAP_INLINE
+#define LLSD_MODERN_MAP_INLINE 1
+#endif
+#ifndef LLSD_MODERN_MAP_FLAT
+#define LLSD_MODERN_MAP_FLAT 16
+#endif
+
+// Floating-point <charconv> support lags behind the integer overloads in some
+// standard libraries; fall back to locale-independent alternatives there.
+#ifndef LLSD_MODERN_HAS_FLOAT_TO_CHARS
+#if defined(__cpp_lib_to_chars) || (defined(_LIBCPP_VERSION) && _LIBCPP_VERSION >= 14000)
+#define LLSD_MODERN_HAS_FLOAT_TO_CHARS 1
+#else
+#define LLSD_MODERN_HAS_FLOAT_TO_CHARS 0
+#endif
+#endif
+#ifndef LLSD_MODERN_HAS_FLOAT_FROM_CHARS
+#if defined(__cpp_lib_to_chars) || (defined(_LIBCPP_VERSION) && _LIBCPP_VERSION >= 200000)
+#define LLSD_MODERN_HAS_FLOAT_FROM_CHARS 1
+#else
+#define LLSD_MODERN_HAS_FLOAT_FROM_CHARS 0
+#endif
+#endif
 
 namespace llsd_modern {
 
@@ -58,45 +114,283 @@ class Value;
 
 namespace detail {
     void _format_binary_recurse(std::ostream& s, const Value& v);
+
+    // Hex digit values: 0-15 for digits and lowercase letters, 0x10 | value
+    // for uppercase letters and 0x80 for anything else
+    inline constexpr auto kHexValues = [] {
+        std::array<std::uint8_t, 256> table{};
+        for (auto& v : table) v = 0x80;
+        for (int c = '0'; c <= '9'; ++c) table[c] = static_cast<std::uint8_t>(c - '0');
+        for (int c = 'a'; c <= 'f'; ++c) table[c] = static_cast<std::uint8_t>(c - 'a' + 10);
+        for (int c = 'A'; c <= 'F'; ++c) table[c] = static_cast<std::uint8_t>(0x10 | (c - 'A' + 10));
+        return table;
+    }();
+
+    // Helper to decode an 8-4-4-4-12 hex UUID, optionally rejecting uppercase
+    inline bool decode_uuid(std::string_view text, std::array<std::uint8_t, 16>& bytes, bool lowercase_only) {
+        if (text.size() != 36 || text[8] != '-' || text[13] != '-' || text[18] != '-' || text[23] != '-') return false;
+        static constexpr std::uint8_t kOffsets[16] = {0, 2, 4, 6, 9, 11, 14, 16, 19, 21, 24, 26, 28, 30, 32, 34};
+        std::uint8_t flags = 0;
+        for (int i = 0; i < 16; ++i) {
+            std::uint8_t hi = kHexValues[static_cast<unsigned char>(text[kOffsets[i]])];
+            std::uint8_t lo = kHexValues[static_cast<unsigned char>(text[kOffsets[i] + 1])];
+            flags |= hi | lo;
+            bytes[i] = static_cast<std::uint8_t>((hi << 4) | (lo & 0x0F));
+        }
+        return !(flags & (lowercase_only ? 0x90 : 0x80));
+    }
+
+    // Days since 1970-01-01 of a proleptic Gregorian date, and back (Howard
+    // Hinnant's days_from_civil / civil_from_days)
+    constexpr std::int64_t days_from_civil(std::int64_t y, unsigned m, unsigned d) {
+        y -= m <= 2;
+        const std::int64_t era = (y >= 0 ? y : y - 399) / 400;
+        const auto yoe = static_cast<unsigned>(y - era * 400);
+        const unsigned doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+        const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+        return era * 146097 + static_cast<std::int64_t>(doe) - 719468;
+    }
+
+    struct CivilDate {
+        std::int64_t year;
+        unsigned month;
+        unsigned day;
+    };
+
+    constexpr CivilDate civil_from_days(std::int64_t z) {
+        z += 719468;
+        const std::int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+        const auto doe = static_cast<unsigned>(z - era * 146097);
+        const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+        const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+        const unsigned mp = (5 * doy + 2) / 153;
+        const unsigned d = doy - (153 * mp + 2) / 5 + 1;
+        const unsigned m = mp < 10 ? mp + 3 : mp - 9;
+        return {static_cast<std::int64_t>(yoe) + era * 400 + (m <= 2), m, d};
+    }
+
+    // Helper to write `v` as exactly `width` zero-padded digits
+    inline char* write_digits(char* p, unsigned v, int width) {
+        for (int i = width - 1; i >= 0; --i) {
+            p[i] = static_cast<char>('0' + v % 10);
+            v /= 10;
+        }
+        return p + width;
+    }
+
+    // Helper to read exactly `width` digits at `pos`
+    inline bool read_digits(std::string_view s, std::size_t pos, int width, unsigned& v) {
+        v = 0;
+        for (int i = 0; i < width; ++i) {
+            char c = s[pos + i];
+            if (c < '0' || c > '9') return false;
+            v = v * 10 + static_cast<unsigned>(c - '0');
+        }
+        return true;
+    }
 }
 
 class LLUUID {
 public:
+    // Length of the canonical 8-4-4-4-12 string form
+    static constexpr std::size_t kStringSize = 36;
+
     LLUUID() : bytes_{} {}
     explicit LLUUID(const std::array<std::uint8_t, 16>& bytes) : bytes_(bytes) {}
 
+    // Writes the canonical lowercase form to `out`: kStringSize characters,
+    // not terminated
+    void toChars(char* out) const {
+        char hex[32];
+#if LLSD_MODERN_HAS_SSE2
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes_.data()));
+        __m128i nibble = _mm_set1_epi8(0x0F);
+        __m128i hi = _mm_and_si128(_mm_srli_epi16(v, 4), nibble);
+        __m128i lo = _mm_and_si128(v, nibble);
+        auto to_ascii = [](__m128i n) {
+            __m128i letter = _mm_and_si128(_mm_cmpgt_epi8(n, _mm_set1_epi8(9)), _mm_set1_epi8('a' - '0' - 10));
+            return _mm_add_epi8(_mm_add_epi8(n, _mm_set1_epi8('0')), letter);
+        };
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(hex), to_ascii(_mm_unpacklo_epi8(hi, lo)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(hex + 16), to_ascii(_mm_unpackhi_epi8(hi, lo)));
+#else
+        static constexpr char kDigits[] = "0123456789abcdef";
+        for (int i = 0; i < 16; ++i) {
+            hex[2 * i] = kDigits[bytes_[i] >> 4];
+            hex[2 * i + 1] = kDigits[bytes_[i] & 0x0F];
+        }
+#endif
+        std::memcpy(out, hex, 8);
+        out[8] = '-';
+        std::memcpy(out + 9, hex + 8, 4);
+        out[13] = '-';
+        std::memcpy(out + 14, hex + 12, 4);
+        out[18] = '-';
+        std::memcpy(out + 19, hex + 16, 4);
+        out[23] = '-';
+        std::memcpy(out + 24, hex + 20, 12);
+    }
+
     std::string toString() const {
-        std::stringstream ss;
-        ss << std::hex << std::setfill('0');
-        for (int i = 0; i < 4; ++i) ss << std::setw(2) << static_cast<int>(bytes_[i]);
-        ss << '-';
-        for (int i = 4; i < 6; ++i) ss << std::setw(2) << static_cast<int>(bytes_[i]);
-        ss << '-';
-        for (int i = 6; i < 8; ++i) ss << std::setw(2) << static_cast<int>(bytes_[i]);
-        ss << '-';
-        for (int i = 8; i < 10; ++i) ss << std::setw(2) << static_cast<int>(bytes_[i]);
-        ss << '-';
-        for (int i = 10; i < 16; ++i) ss << std::setw(2) << static_cast<int>(bytes_[i]);
-        return ss.str();
+        std::string s(kStringSize, '\0');
+        toChars(&s[0]);
+        return s;
+    }
+
+    // Parses the canonical form, in either case
+    static std::optional<LLUUID> parse(std::string_view text) {
+        LLUUID uuid;
+        if (!detail::decode_uuid(text, uuid.bytes_, false)) return std::nullopt;
+        return uuid;
+    }
+
+    // Batch forms: toChars writes `count` UUIDs back to back, count *
+    // kStringSize characters; parse returns how many of `texts` parsed before
+    // the first that did not
+    static void toChars(const LLUUID* uuids, std::size_t count, char* out) {
+        for (std::size_t i = 0; i < count; ++i) uuids[i].toChars(out + i * kStringSize);
+    }
+    static std::size_t parse(const std::string_view* texts, std::size_t count, LLUUID* out) {
+        for (std::size_t i = 0; i < count; ++i) {
+            if (!detail::decode_uuid(texts[i], out[i].bytes_, false)) return i;
+        }
+        return count;
+    }
+
+    const std::array<std::uint8_t, 16>& bytes() const { return bytes_; }
+
+    bool isNull() const {
+        std::uint64_t halves[2];
+        std::memcpy(halves, bytes_.data(), 16);
+        return (halves[0] | halves[1]) == 0;
+    }
+
+    // Hash of all 128 bits, each half passed through the MurmurHash3
+    // finalizer so that similar IDs spread across buckets
+    std::size_t hash() const {
+        std::uint64_t halves[2];
+        std::memcpy(halves, bytes_.data(), 16);
+        auto mix = [](std::uint64_t h) {
+            h ^= h >> 33;
+            h *= 0xff51afd7ed558ccdULL;
+            h ^= h >> 33;
+            h *= 0xc4ceb9fe1a85ec53ULL;
+            h ^= h >> 33;
+            return h;
+        };
+        return static_cast<std::size_t>(mix(halves[0] ^ mix(halves[1] + 0x9e3779b97f4a7c15ULL)));
     }
 
+    // Byte order, which matches the order of the string forms
+    friend bool operator==(const LLUUID& a, const LLUUID& b) { return std::memcmp(a.bytes_.data(), b.bytes_.data(), 16) == 0; }
+    friend bool operator!=(const LLUUID& a, const LLUUID& b) { return !(a == b); }
+    friend bool operator<(const LLUUID& a, const LLUUID& b) { return std::memcmp(a.bytes_.data(), b.bytes_.data(), 16) < 0; }
+    friend bool operator>(const LLUUID& a, const LLUUID& b) { return b < a; }
+    friend bool operator<=(const LLUUID& a, const LLUUID& b) { return !(b < a); }
+    friend bool operator>=(const LLUUID& a, const LLUUID& b) { return !(a < b); }
+
 private:
     std::array<std::uint8_t, 16> bytes_;
     friend void detail::_format_binary_recurse(std::ostream& s, const Value& v);
 };
 
+} // namespace llsd_modern
+
+template <>
+struct std::hash<llsd_modern::LLUUID> {
+    std::size_t operator()(const llsd_modern::LLUUID& uuid) const noexcept { return uuid.hash(); }
+};
+
+namespace llsd_modern {
+
 class LLDate {
 public:
+    // Longest string form: "YYYY-MM-DDTHH:MM:SS.ffffffZ", allowing for
+    // years beyond four digits
+    static constexpr std::size_t kMaxStringSize = 48;
+
     LLDate() : time_point_() {}
     explicit LLDate(const std::chrono::system_clock::time_point& time_point) : time_point_(time_point) {}
 
+    // Writes the ISO-8601 UTC form python-llsd uses, with microseconds only
+    // when there are any, to `out` and returns its length. Needs no locale,
+    // stream or global state.
+    std::size_t toChars(char* out) const {
+        using namespace std::chrono;
+        constexpr std::int64_t kMicrosPerDay = 86400LL * 1000000;
+        std::int64_t us = round<microseconds>(time_point_.time_since_epoch()).count();
+        std::int64_t days = us / kMicrosPerDay;
+        std::int64_t rem = us % kMicrosPerDay;
+        if (rem < 0) {
+            rem += kMicrosPerDay;
+            --days;
+        }
+        auto date = detail::civil_from_days(days);
+        auto seconds = static_cast<unsigned>(rem / 1000000);
+        auto fraction = static_cast<unsigned>(rem % 1000000);
+
+        char* p = out;
+        if (date.year >= 0 && date.year <= 9999) {
+            p = detail::write_digits(p, static_cast<unsigned>(date.year), 4);
+        } else {
+            p = std::to_chars(p, p + 20, date.year).ptr;
+        }
+        *p++ = '-';
+        p = detail::write_digits(p, date.month, 2);
+        *p++ = '-';
+        p = detail::write_digits(p, date.day, 2);
+        *p++ = 'T';
+        p = detail::write_digits(p, seconds / 3600, 2);
+        *p++ = ':';
+        p = detail::write_digits(p, seconds / 60 % 60, 2);
+        *p++ = ':';
+        p = detail::write_digits(p, seconds % 60, 2);
+        if (fraction) {
+            *p++ = '.';
+            p = detail::write_digits(p, fraction, 6);
+        }
+        *p++ = 'Z';
+        return static_cast<std::size_t>(p - out);
+    }
+
     std::string toString() const {
-        auto time_t = std::chrono::system_clock::to_time_t(time_point_);
-        std::stringstream ss;
-        ss << std::put_time(std::gmtime(&time_t), "%Y-%m-%dT%H:%M:%SZ");
-        return ss.str();
+        char buf[kMaxStringSize];
+        return std::string(buf, toChars(buf));
     }
 
+    // Parses "YYYY-MM-DDTHH:MM:SSZ" with optional fractional seconds
+    static std::optional<LLDate> parse(std::string_view s) {
+        if (s.size() < 20 || s.back() != 'Z') return std::nullopt;
+        unsigned year, month, day, hour, minute, second;
+        if (!detail::read_digits(s, 0, 4, year) || s[4] != '-' || !detail::read_digits(s, 5, 2, month) ||
+            s[7] != '-' || !detail::read_digits(s, 8, 2, day) || s[10] != 'T' ||
+            !detail::read_digits(s, 11, 2, hour) || s[13] != ':' || !detail::read_digits(s, 14, 2, minute) ||
+            s[16] != ':' || !detail::read_digits(s, 17, 2, second)) {
+            return std::nullopt;
+        }
+        if (month < 1 || month > 12 || day < 1 || day > 31 || hour > 23 || minute > 59 || second > 60) {
+            return std::nullopt;
+        }
+        // Fractional digits beyond nanoseconds are dropped
+        std::string_view fraction = s.substr(19, s.size() - 20);
+        std::int64_t nanos = 0;
+        if (!fraction.empty()) {
+            if (fraction.size() < 2 || fraction[0] != '.') return std::nullopt;
+            std::int64_t scale = 100000000;
+            for (char c : fraction.substr(1)) {
+                if (c < '0' || c > '9') return std::nullopt;
+                nanos += (c - '0') * scale;
+                scale /= 10;
+            }
+        }
+        std::int64_t seconds = detail::days_from_civil(year, month, day) * 86400 + hour * 3600 + minute * 60 + second;
+        auto since_epoch = std::chrono::seconds(seconds) + std::chrono::nanoseconds(nanos);
+        return LLDate(std::chrono::system_clock::time_point(
+            std::chrono::duration_cast<std::chrono::system_clock::duration>(since_epoch)));
+    }
+
+    const std::chrono::system_clock::time_point& timePoint() const { return time_point_; }
+
 private:
     std::chrono::system_clock::time_point time_point_;
     friend void detail::_format_binary_recurse(std::ostream& s, const Value& v);
@@ -104,8 +398,8 @@ private:
 
 class Value;
 
-using Array = std::vector<Value>;
-using Map = std::map<std::string, Value>;
+class Array;
+class Map;
 
 struct Undef {};
 struct URI { std::string s; };
@@ -138,9 +432,506 @@ public:
     Value& operator=(const Value& other);
     Value& operator=(Value&& other) noexcept = default;
 
+    // Structural comparison: same type and, for containers, equal elements
+    friend bool operator==(const Value& a, const Value& b);
+    friend bool operator!=(const Value& a, const Value& b) { return !(a == b); }
+
+    // Hash consistent with operator==
+    std::size_t hash() const;
+
     variant_type data;
 };
 
+namespace detail {
+
+// Vector that keeps up to N elements inline and moves to the heap beyond
+// that, so short containers cost no allocation of their own
+template <typename T, std::size_t N>
+class SmallVector {
+    static constexpr bool kNothrowMove = std::is_nothrow_move_constructible_v<T>;
+
+public:
+    using value_type = T;
+    using size_type = std::size_t;
+    using iterator = T*;
+    using const_iterator = const T*;
+
+    SmallVector() noexcept : data_(inline_data()) {}
+
+    SmallVector(const SmallVector& other) : SmallVector() {
+        reserve(other.size_);
+        for (const T& v : other) emplace_back(v);
+    }
+
+    // Heap storage is handed over whole, but inline elements are moved one
+    // by one, so moving is only as nothrow as T's move. Map entries, whose
+    // const keys are copied, can throw.
+    SmallVector(SmallVector&& other) noexcept(kNothrowMove) : SmallVector() { take(std::move(other)); }
+
+    ~SmallVector() { release(); }
+
+    SmallVector& operator=(const SmallVector& other) {
+        if (this != &other) {
+            SmallVector copy(other);
+            *this = std::move(copy);
+        }
+        return *this;
+    }
+
+    SmallVector& operator=(SmallVector&& other) noexcept(kNothrowMove) {
+        if (this != &other) {
+            release();
+            data_ = inline_data();
+            capacity_ = N;
+            take(std::move(other));
+        }
+        return *this;
+    }
+
+    size_type size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    size_type capacity() const { return capacity_; }
+    bool is_inline() const { return data_ == inline_data(); }
+
+    T* data() { return data_; }
+    const T* data() const { return data_; }
+    iterator begin() { return data_; }
+    iterator end() { return data_ + size_; }
+    const_iterator begin() const { return data_; }
+    const_iterator end() const { return data_ + size_; }
+    const_iterator cbegin() const { return data_; }
+    const_iterator cend() const { return data_ + size_; }
+
+    T& operator[](size_type i) { return data_[i]; }
+    const T& operator[](size_type i) const { return data_[i]; }
+    T& at(size_type i) {
+        if (i >= size_) throw std::out_of_range("SmallVector index out of range");
+        return data_[i];
+    }
+    const T& at(size_type i) const {
+        if (i >= size_) throw std::out_of_range("SmallVector index out of range");
+        return data_[i];
+    }
+    T& front() { return data_[0]; }
+    const T& front() const { return data_[0]; }
+    T& back() { return data_[size_ - 1]; }
+    const T& back() const { return data_[size_ - 1]; }
+
+    void reserve(size_type n) {
+        if (n > capacity_) reallocate(n);
+    }
+
+    void clear() {
+        for (size_type i = 0; i < size_; ++i) data_[i].~T();
+        size_ = 0;
+    }
+
+    void push_back(const T& v) { emplace_back(v); }
+    void push_back(T&& v) { emplace_back(std::move(v)); }
+
+    // GCC 12 inlines Value's variant move here without tracking which
+    // alternative the source holds, and warns that the Binary one may be
+    // uninitialized; the warning is scoped to this function
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+    template <typename... Args>
+    T& emplace_back(Args&&... args) {
+        if (size_ == capacity_) return grow_emplace_back(std::forward<Args>(args)...);
+        return *new (data_ + size_++) T(std::forward<Args>(args)...);
+    }
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+    void pop_back() { data_[--size_].~T(); }
+
+    void resize(size_type n) {
+        while (size_ > n) pop_back();
+        reserve(n);
+        while (size_ < n) emplace_back();
+    }
+
+    // Elements are shifted by constructing each one in place of its
+    // neighbour rather than by assignment, so this works for element types
+    // with const members such as map entries
+    template <typename... Args>
+    iterator emplace(const_iterator pos, Args&&... args) {
+        size_type i = static_cast<size_type>(pos - data_);
+        if (i == size_) {
+            emplace_back(std::forward<Args>(args)...);
+            return data_ + i;
+        }
+        T v(std::forward<Args>(args)...);
+        if (size_ == capacity_) reallocate(std::max<size_type>(2 * capacity_, 4));
+        new (data_ + size_) T(std::move(data_[size_ - 1]));
+        for (size_type j = size_ - 1; j > i; --j) {
+            data_[j].~T();
+            new (data_ + j) T(std::move(data_[j - 1]));
+        }
+        data_[i].~T();
+        new (data_ + i) T(std::move(v));
+        ++size_;
+        return data_ + i;
+    }
+
+    iterator insert(const_iterator pos, const T& v) { return emplace(pos, v); }
+    iterator insert(const_iterator pos, T&& v) { return emplace(pos, std::move(v)); }
+
+    iterator erase(const_iterator pos) {
+        size_type i = static_cast<size_type>(pos - data_);
+        for (size_type j = i; j + 1 < size_; ++j) {
+            data_[j].~T();
+            new (data_ + j) T(std::move(data_[j + 1]));
+        }
+        pop_back();
+        return data_ + i;
+    }
+
+    friend bool operator==(const SmallVector& a, const SmallVector& b) {
+        return a.size_ == b.size_ && std::equal(a.begin(), a.end(), b.begin());
+    }
+    friend bool operator!=(const SmallVector& a, const SmallVector& b) { return !(a == b); }
+
+private:
+    T* inline_data() { return reinterpret_cast<T*>(inline_); }
+    const T* inline_data() const { return reinterpret_cast<const T*>(inline_); }
+
+    // emplace_back's slow path, kept apart so the common one stays small.
+    // Constructs in the new storage before moving the elements over, in case
+    // the arguments refer to one of them.
+    template <typename... Args>
+    T& grow_emplace_back(Args&&... args) {
+        size_type n = std::max<size_type>(2 * capacity_, 4);
+        T* heap = allocate(n);
+        try {
+            new (heap + size_) T(std::forward<Args>(args)...);
+        } catch (...) {
+            std::allocator<T>().deallocate(heap, n);
+            throw;
+        }
+        adopt(heap, n);
+        return data_[size_++];
+    }
+
+    static T* allocate(size_type n) {
+        if (n > std::numeric_limits<std::uint32_t>::max()) throw std::length_error("SmallVector too large");
+        return std::allocator<T>().allocate(n);
+    }
+
+    void reallocate(size_type n) { adopt(allocate(n), n); }
+
+    // Moves the elements into `heap`, which has room for `n`, and frees the
+    // old storage
+    void adopt(T* heap, size_type n) {
+        for (size_type i = 0; i < size_; ++i) {
+            new (heap + i) T(std::move(data_[i]));
+            data_[i].~T();
+        }
+        if (!is_inline()) std::allocator<T>().deallocate(data_, capacity_);
+        data_ = heap;
+        capacity_ = static_cast<std::uint32_t>(n);
+    }
+
+    // Takes the elements of `other`, which is left empty; expects this
+    // vector to be empty and inline
+    void take(SmallVector&& other) noexcept(kNothrowMove) {
+        if (!other.is_inline()) {
+            data_ = other.data_;
+            capacity_ = other.capacity_;
+            size_ = other.size_;
+        } else {
+            for (size_type i = 0; i < other.size_; ++i) {
+                new (data_ + i) T(std::move(other.data_[i]));
+                other.data_[i].~T();
+            }
+            size_ = other.size_;
+        }
+        other.data_ = other.inline_data();
+        other.capacity_ = N;
+        other.size_ = 0;
+    }
+
+    void release() {
+        clear();
+        if (!is_inline()) std::allocator<T>().deallocate(data_, capacity_);
+    }
+
+    // 32-bit counts keep the header small; LLSD containers are bounded by
+    // the 32-bit sizes of the binary format anyway
+    T* data_;
+    std::uint32_t size_ = 0;
+    std::uint32_t capacity_ = N;
+    alignas(T) unsigned char inline_[sizeof(T) * (N ? N : 1)];
+};
+
+} // namespace detail
+
+// Elements of an LLSD array, with the interface of std::vector<Value>. Up to
+// LLSD_MODERN_ARRAY_INLINE elements are stored inline, without an allocation
+// of their own. Large arrays of plain numbers can be converted to the more
+// compact PackedArray.
+class Array : public detail::SmallVector<Value, LLSD_MODERN_ARRAY_INLINE> {
+public:
+    Array() = default;
+    Array(std::initializer_list<Value> values) {
+        reserve(values.size());
+        for (const Value& v : values) push_back(v);
+    }
+};
+
+// Map from keys to Values, iterated in key order like std::map. Up to
+// LLSD_MODERN_MAP_FLAT entries are kept in a vector sorted by key, the first
+// LLSD_MODERN_MAP_INLINE of them inline; inserting more moves them into a
+// std::map. Unlike std::map, inserting or erasing may invalidate iterators
+// and references while the map is flat, and when it moves into the tree.
+class Map {
+    using Tree = std::map<std::string, Value, std::less<>>;
+    static constexpr std::size_t kFlat = LLSD_MODERN_MAP_FLAT;
+
+public:
+    using key_type = std::string;
+    using mapped_type = Value;
+    using value_type = std::pair<const std::string, Value>;
+    using size_type = std::size_t;
+
+    template <bool Const>
+    class basic_iterator {
+        using Owner = std::conditional_t<Const, const Map*, Map*>;
+        using TreeIt = std::conditional_t<Const, Tree::const_iterator, Tree::iterator>;
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = Map::value_type;
+        using difference_type = std::ptrdiff_t;
+        using pointer = std::conditional_t<Const, const value_type*, value_type*>;
+        using reference = std::conditional_t<Const, const value_type&, value_type&>;
+
+        basic_iterator() = default;
+        basic_iterator(Owner map, size_type i) : map_(map), i_(i) {}
+        basic_iterator(Owner map, TreeIt it) : map_(map), it_(it) {}
+        template <bool C = Const, typename = std::enable_if_t<C>>
+        basic_iterator(const basic_iterator<false>& other) : map_(other.map_), i_(other.i_), it_(other.it_) {}
+
+        reference operator*() const { return map_->tree_ ? *it_ : map_->flat_[i_]; }
+        pointer operator->() const { return &**this; }
+        basic_iterator& operator++() {
+            if (map_->tree_) {
+                ++it_;
+            } else {
+                ++i_;
+            }
+            return *this;
+        }
+        basic_iterator operator++(int) {
+            basic_iterator old = *this;
+            ++*this;
+            return old;
+        }
+        bool operator==(const basic_iterator& other) const {
+            return map_->tree_ ? it_ == other.it_ : i_ == other.i_;
+        }
+        bool operator!=(const basic_iterator& other) const { return !(*this == other); }
+
+    private:
+        friend class Map;
+        friend class basic_iterator<true>;
+        Owner map_ = nullptr;
+        size_type i_ = 0;
+        TreeIt it_{};
+    };
+    using iterator = basic_iterator<false>;
+    using const_iterator = basic_iterator<true>;
+
+    Map() = default;
+
+    Map(const Map& other) : flat_(other.flat_) {
+        if (other.tree_) tree_ = std::make_unique<Tree>(*other.tree_);
+    }
+
+    // Nothrow only when the entries are: inline ones copy their const keys
+    Map(Map&& other) = default;
+
+    Map& operator=(const Map& other) {
+        if (this != &other) {
+            Map copy(other);
+            *this = std::move(copy);
+        }
+        return *this;
+    }
+
+    Map& operator=(Map&& other) = default;
+
+    size_type size() const { return tree_ ? tree_->size() : flat_.size(); }
+    bool empty() const { return size() == 0; }
+    // Whether the entries are stored without an allocation of their own
+    bool is_inline() const { return !tree_ && flat_.is_inline(); }
+
+    // Makes room for `n` entries up front, for callers that know the count
+    void reserve(size_type n) {
+        if (!tree_ && n <= kFlat) flat_.reserve(n);
+    }
+
+    // Heap bytes of the entry storage itself, not counting what the keys and
+    // values own
+    size_type storage_size() const {
+        // A std::map node adds a color and three links to each entry
+        constexpr std::size_t kNodeSize = sizeof(value_type) + 4 * sizeof(void*);
+        if (tree_) return sizeof(Tree) + tree_->size() * kNodeSize;
+        return flat_.is_inline() ? 0 : flat_.capacity() * sizeof(value_type);
+    }
+
+    iterator begin() { return tree_ ? iterator(this, tree_->begin()) : iterator(this, size_type(0)); }
+    iterator end() { return tree_ ? iterator(this, tree_->end()) : iterator(this, flat_.size()); }
+    const_iterator begin() const {
+        return tree_ ? const_iterator(this, tree_->cbegin()) : const_iterator(this, size_type(0));
+    }
+    const_iterator end() const {
+        return tree_ ? const_iterator(this, tree_->cend()) : const_iterator(this, flat_.size());
+    }
+    const_iterator cbegin() const { return begin(); }
+    const_iterator cend() const { return end(); }
+
+    iterator find(std::string_view key) {
+        if (tree_) return iterator(this, tree_->find(key));
+        auto [pos, found] = flat_find(key);
+        return found ? iterator(this, pos) : end();
+    }
+    const_iterator find(std::string_view key) const {
+        if (tree_) return const_iterator(this, tree_->find(key));
+        auto [pos, found] = flat_find(key);
+        return found ? const_iterator(this, pos) : end();
+    }
+    size_type count(std::string_view key) const { return find(key) != end(); }
+
+    // First entry whose key is not less than (lower_bound) or is greater
+    // than (upper_bound) `key`
+    iterator lower_bound(std::string_view key) {
+        return tree_ ? iterator(this, tree_->lower_bound(key)) : iterator(this, flat_find(key).first);
+    }
+    const_iterator lower_bound(std::string_view key) const {
+        return tree_ ? const_iterator(this, tree_->lower_bound(key)) : const_iterator(this, flat_find(key).first);
+    }
+    iterator upper_bound(std::string_view key) {
+        if (tree_) return iterator(this, tree_->upper_bound(key));
+        auto [pos, found] = flat_find(key);
+        return iterator(this, pos + found);
+    }
+    const_iterator upper_bound(std::string_view key) const {
+        if (tree_) return const_iterator(this, tree_->upper_bound(key));
+        auto [pos, found] = flat_find(key);
+        return const_iterator(this, pos + found);
+    }
+    std::pair<iterator, iterator> equal_range(std::string_view key) { return {lower_bound(key), upper_bound(key)}; }
+    std::pair<const_iterator, const_iterator> equal_range(std::string_view key) const {
+        return {lower_bound(key), upper_bound(key)};
+    }
+
+    Value& at(std::string_view key) {
+        auto it = find(key);
+        if (it == end()) throw std::out_of_range("Map key not found");
+        return it->second;
+    }
+    const Value& at(std::string_view key) const {
+        auto it = find(key);
+        if (it == end()) throw std::out_of_range("Map key not found");
+        return it->second;
+    }
+
+    Value& operator[](const std::string& key) { return try_emplace(key).first->second; }
+    Value& operator[](std::string&& key) { return try_emplace(std::move(key)).first->second; }
+
+    template <typename K, typename... Args>
+    std::pair<iterator, bool> try_emplace(K&& key, Args&&... args) {
+        if (!tree_) {
+            auto [pos, found] = flat_find(key);
+            if (found) return {iterator(this, pos), false};
+            if (flat_.size() < kFlat) {
+                flat_.emplace(flat_.begin() + pos, std::piecewise_construct,
+                              std::forward_as_tuple(std::forward<K>(key)),
+                              std::forward_as_tuple(std::forward<Args>(args)...));
+                return {iterator(this, pos), true};
+            }
+            spill();
+        }
+        auto [it, inserted] = tree_->try_emplace(std::string(std::forward<K>(key)), std::forward<Args>(args)...);
+        return {iterator(this, it), inserted};
+    }
+
+    template <typename K, typename... Args>
+    std::pair<iterator, bool> emplace(K&& key, Args&&... args) {
+        return try_emplace(std::forward<K>(key), std::forward<Args>(args)...);
+    }
+
+    std::pair<iterator, bool> insert(const value_type& entry) { return try_emplace(entry.first, entry.second); }
+    std::pair<iterator, bool> insert(value_type&& entry) {
+        return try_emplace(entry.first, std::move(entry.second));
+    }
+
+    template <typename K, typename M>
+    std::pair<iterator, bool> insert_or_assign(K&& key, M&& value) {
+        // try_emplace leaves `value` alone when the key is already present
+        auto result = try_emplace(std::forward<K>(key), std::forward<M>(value));
+        if (!result.second) result.first->second = std::forward<M>(value);
+        return result;
+    }
+
+    template <typename K, typename... Args>
+    iterator emplace_hint(const_iterator hint, K&& key, Args&&... args) {
+        if (tree_ && hint.map_ == this) {
+            return iterator(this, tree_->emplace_hint(hint.it_, std::forward<K>(key), std::forward<Args>(args)...));
+        }
+        return try_emplace(std::forward<K>(key), std::forward<Args>(args)...).first;
+    }
+
+    size_type erase(std::string_view key) {
+        if (tree_) {
+            auto it = tree_->find(key);
+            if (it == tree_->end()) return 0;
+            tree_->erase(it);
+            return 1;
+        }
+        auto [pos, found] = flat_find(key);
+        if (!found) return 0;
+        flat_.erase(flat_.begin() + pos);
+        return 1;
+    }
+
+    // Erases the entry at `pos`, returning the one after it
+    iterator erase(const_iterator pos) {
+        if (tree_) return iterator(this, tree_->erase(pos.it_));
+        flat_.erase(flat_.begin() + pos.i_);
+        return iterator(this, pos.i_);
+    }
+    iterator erase(iterator pos) { return erase(const_iterator(pos)); }
+
+    void clear() {
+        flat_.clear();
+        tree_.reset();
+    }
+
+private:
+    using Flat = detail::SmallVector<value_type, LLSD_MODERN_MAP_INLINE>;
+
+    // Position of `key` in the flat entries, and whether it is present
+    std::pair<size_type, bool> flat_find(std::string_view key) const {
+        auto it = std::lower_bound(flat_.begin(), flat_.end(), key,
+                                   [](const value_type& entry, std::string_view k) { return entry.first < k; });
+        return {static_cast<size_type>(it - flat_.begin()), it != flat_.end() && it->first == key};
+    }
+
+    void spill() {
+        auto tree = std::make_unique<Tree>();
+        for (value_type& entry : flat_) tree->emplace_hint(tree->end(), entry.first, std::move(entry.second));
+        flat_ = Flat();
+        tree_ = std::move(tree);
+    }
+
+    Flat flat_;
+    std::unique_ptr<Tree> tree_;
+};
+
 // Forward declaration for the parser
 Value parse_binary(std::istream& s);
 
@@ -174,13 +965,153 @@ inline Value& Value::operator=(const Value& other) {
     return *this;
 }
 
+// Containers compare by element, and reals with ==, so a NaN is unequal to
+// itself. A null container equals an empty one.
+inline bool operator==(const Value& a, const Value& b) {
+    if (a.data.index() != b.data.index()) return false;
+    return std::visit([&](const auto& x) -> bool {
+        using T = std::decay_t<decltype(x)>;
+        const T& y = std::get<T>(b.data);
+        if constexpr (std::is_same_v<T, Undef>) {
+            return true;
+        } else if constexpr (std::is_same_v<T, LLDate>) {
+            return x.timePoint() == y.timePoint();
+        } else if constexpr (std::is_same_v<T, URI>) {
+            return x.s == y.s;
+        } else if constexpr (std::is_same_v<T, Binary>) {
+            return x.b == y.b;
+        } else if constexpr (std::is_same_v<T, std::unique_ptr<Array>>) {
+            const Array empty{};
+            const Array& xa = x ? *x : empty;
+            const Array& ya = y ? *y : empty;
+            return xa == ya;
+        } else if constexpr (std::is_same_v<T, std::unique_ptr<Map>>) {
+            const Map empty{};
+            const Map& xm = x ? *x : empty;
+            const Map& ym = y ? *y : empty;
+            if (xm.size() != ym.size()) return false;
+            // Both iterate in key order
+            for (auto xi = xm.begin(), yi = ym.begin(); xi != xm.end(); ++xi, ++yi) {
+                if (xi->first != yi->first || xi->second != yi->second) return false;
+            }
+            return true;
+        } else {
+            return x == y;
+        }
+    }, a.data);
+}
+
+namespace detail {
+
+inline std::size_t hash_mix(std::size_t seed, std::size_t h) {
+    return seed ^ (h + static_cast<std::size_t>(0x9e3779b97f4a7c15ULL) + (seed << 6) + (seed >> 2));
+}
+
+// Starting hash of a container, before its elements (and keys) are mixed
+// in one at a time in iteration order
+inline std::size_t hash_container_seed(const Value& v, std::size_t size) {
+    return hash_mix(v.data.index(), size);
+}
+
+// Heap bytes of a string's buffer, or 0 while it fits in the string itself
+inline std::size_t string_heap_size(const std::string& s) {
+    const char* p = s.data();
+    const char* self = reinterpret_cast<const char*>(&s);
+    return (p >= self && p < self + sizeof s) ? 0 : s.capacity() + 1;
+}
+
+template <typename T, std::size_t N>
+std::size_t vector_heap_size(const SmallVector<T, N>& v) {
+    return v.is_inline() ? 0 : v.capacity() * sizeof(T);
+}
+
+// Heap bytes `v` owns directly: its container, element storage and map keys,
+// but not what its elements own in turn
+inline std::size_t shallow_memory_usage(const Value& v) {
+    return std::visit([](const auto& x) -> std::size_t {
+        using T = std::decay_t<decltype(x)>;
+        if constexpr (std::is_same_v<T, std::string>) {
+            return string_heap_size(x);
+        } else if constexpr (std::is_same_v<T, URI>) {
+            return string_heap_size(x.s);
+        } else if constexpr (std::is_same_v<T, Binary>) {
+            return x.b.capacity();
+        } else if constexpr (std::is_same_v<T, std::unique_ptr<Array>>) {
+            if (!x) return 0;
+            return sizeof(Array) + vector_heap_size(*x);
+        } else if constexpr (std::is_same_v<T, std::unique_ptr<Map>>) {
+            if (!x) return 0;
+            std::size_t bytes = sizeof(Map) + x->storage_size();
+            for (const auto& entry : *x) bytes += string_heap_size(entry.first);
+            return bytes;
+        } else {
+            return 0;
+        }
+    }, v.data);
+}
+
+} // namespace detail
+
+inline std::size_t Value::hash() const {
+    return std::visit([this](const auto& x) -> std::size_t {
+        using T = std::decay_t<decltype(x)>;
+        std::size_t seed = data.index();
+        if constexpr (std::is_same_v<T, Undef>) {
+            return seed;
+        } else if constexpr (std::is_same_v<T, double>) {
+            // 0.0 == -0.0, so they must hash alike
+            return detail::hash_mix(seed, std::hash<double>()(x == 0 ? 0.0 : x));
+        } else if constexpr (std::is_same_v<T, std::string>) {
+            return detail::hash_mix(seed, std::hash<std::string_view>()(x));
+        } else if constexpr (std::is_same_v<T, LLUUID>) {
+            return detail::hash_mix(seed, x.hash());
+        } else if constexpr (std::is_same_v<T, LLDate>) {
+            return detail::hash_mix(seed, std::hash<std::int64_t>()(x.timePoint().time_since_epoch().count()));
+        } else if constexpr (std::is_same_v<T, URI>) {
+            return detail::hash_mix(seed, std::hash<std::string_view>()(x.s));
+        } else if constexpr (std::is_same_v<T, Binary>) {
+            std::string_view bytes(reinterpret_cast<const char*>(x.b.data()), x.b.size());
+            return detail::hash_mix(seed, std::hash<std::string_view>()(bytes));
+        } else if constexpr (std::is_same_v<T, std::unique_ptr<Array>>) {
+            seed = detail::hash_container_seed(*this, x ? x->size() : 0);
+            if (x) {
+                for (const Value& item : *x) seed = detail::hash_mix(seed, item.hash());
+            }
+            return seed;
+        } else if constexpr (std::is_same_v<T, std::unique_ptr<Map>>) {
+            seed = detail::hash_container_seed(*this, x ? x->size() : 0);
+            if (x) {
+                for (const auto& [key, value] : *x) {
+                    seed = detail::hash_mix(seed, std::hash<std::string_view>()(key));
+                    seed = detail::hash_mix(seed, value.hash());
+                }
+            }
+            return seed;
+        } else {
+            return detail::hash_mix(seed, std::hash<T>()(x));
+        }
+    }, data);
+}
+
+// Approximate heap bytes owned by `v` and everything under it, not counting
+// the Value object itself
+inline std::size_t memory_usage(const Value& v) {
+    std::size_t bytes = detail::shallow_memory_usage(v);
+    if (auto array = std::get_if<std::unique_ptr<Array>>(&v.data); array && *array) {
+        for (const Value& item : **array) bytes += memory_usage(item);
+    } else if (auto map = std::get_if<std::unique_ptr<Map>>(&v.data); map && *map) {
+        for (const auto& entry : **map) bytes += memory_usage(entry.second);
+    }
+    return bytes;
+}
+
 namespace detail {
 
 // Helper to read a specific number of bytes
 inline std::vector<char> read_bytes(std::istream& s, size_t n) {
     std::vector<char> bytes(n);
     s.read(bytes.data(), n);
-    if (s.gcount() != n) {
+    if (static_cast<std::size_t>(s.gcount()) != n) {
         throw std::runtime_error("Unexpected end of stream");
     }
     return bytes;
@@ -234,22 +1165,185 @@ inline std::string read_string(std::istream& s) {
 }
 } // namespace detail
 
-// Forward declaration for the JSON formatter
-std::string format_json(const Value& v);
-void format_binary(std::ostream& s, const Value& v);
-
 namespace detail {
 
-// Helper to write a big-endian integer
-inline void write_i32_be(std::ostream& s, std::int32_t val) {
-    s.put((val >> 24) & 0xFF);
-    s.put((val >> 16) & 0xFF);
-    s.put((val >> 8) & 0xFF);
-    s.put(val & 0xFF);
+// Numeric conversion shared by the text formats. Integers and reals are
+// written and read with <charconv>, which is locale-independent, and reals
+// are always written in the shortest form that parses back to the same bits.
+
+// Largest decimal point position written in fixed notation by format_real:
+// 15 matches nlohmann::json::dump(), 16 matches Python's repr().
+constexpr int kJsonRealMaxExp = 15;
+constexpr int kPythonRealMaxExp = 16;
+
+// Buffer size sufficient for any format_real / format_integer output
+constexpr std::size_t kNumberBufferSize = 32;
+
+inline char* format_integer(char* first, std::int32_t value) {
+    return std::to_chars(first, first + kNumberBufferSize, value).ptr;
 }
 
-// Helper to write a big-endian double
-inline void write_double_be(std::ostream& s, double val) {
+// Lays out `len` significant digits at `buf` as digits * 10^decimal_exponent,
+// using fixed notation when the decimal point falls in (-4, max_exp] and
+// printf("%g")-style exponential notation otherwise.
+inline char* layout_real_digits(char* buf, int len, int decimal_exponent, int max_exp) {
+    const int k = len;
+    const int n = len + decimal_exponent;
+    if (k <= n && n <= max_exp) {
+        // digits[000].0
+        std::memset(buf + k, '0', n - k);
+        buf[n] = '.';
+        buf[n + 1] = '0';
+        return buf + n + 2;
+    }
+    if (0 < n && n <= max_exp) {
+        // dig.its
+        std::memmove(buf + n + 1, buf + n, k - n);
+        buf[n] = '.';
+        return buf + k + 1;
+    }
+    if (-4 < n && n <= 0) {
+        // 0.[000]digits
+        std::memmove(buf + 2 - n, buf, k);
+        buf[0] = '0';
+        buf[1] = '.';
+        std::memset(buf + 2, '0', -n);
+        return buf + 2 - n + k;
+    }
+    // d[.igits]e+XX
+    if (k == 1) {
+        buf += 1;
+    } else {
+        std::memmove(buf + 2, buf + 1, k - 1);
+        buf[1] = '.';
+        buf += k + 1;
+    }
+    *buf++ = 'e';
+    int e = n - 1;
+    *buf++ = e < 0 ? '-' : '+';
+    if (e < 0) e = -e;
+    if (e < 10) *buf++ = '0';
+    return std::to_chars(buf, buf + 4, e).ptr;
+}
+
+// Writes the shortest round-trip representation of a finite `value`.
+// Non-finite values are written as "nan", "inf" or "-inf"; callers whose
+// format has no such spelling must check std::isfinite() first.
+inline char* format_real(char* first, double value, int max_exp = kJsonRealMaxExp) {
+    if (std::isnan(value)) {
+        std::memcpy(first, "nan", 3);
+        return first + 3;
+    }
+    if (std::signbit(value)) {
+        *first++ = '-';
+        value = -value;
+    }
+    if (std::isinf(value)) {
+        std::memcpy(first, "inf", 3);
+        return first + 3;
+    }
+    int len = 0;
+    int decimal_exponent = 0;
+#if LLSD_MODERN_HAS_FLOAT_TO_CHARS
+    // Shortest scientific form, e.g. "3.14e+00"; collect its digits and
+    // rebase the exponent onto the last digit
+    char sci[kNumberBufferSize];
+    char* end = std::to_chars(sci, sci + sizeof(sci), value, std::chars_format::scientific).ptr;
+    const char* p = sci;
+    for (; p != end && *p != 'e'; ++p) {
+        if (*p != '.') first[len++] = *p;
+    }
+    int e = 0;
+    if (p != end) {
+        ++p;
+        if (*p == '+') ++p;
+        std::from_chars(p, end, e);
+    }
+    decimal_exponent = e - (len - 1);
+#else
+    if (value == 0) {
+        first[len++] = '0';
+    } else {
+        nlohmann::detail::dtoa_impl::grisu2(first, len, decimal_exponent, value);
+    }
+#endif
+    return layout_real_digits(first, len, decimal_exponent, max_exp);
+}
+
+// Parses a whole decimal integer with an optional sign; false on malformed
+// or out-of-range input.
+inline bool parse_integer(std::string_view str, std::int32_t& out) {
+    const char* first = str.data();
+    const char* last = first + str.size();
+    if (first != last && *first == '+') ++first;
+    auto res = std::from_chars(first, last, out);
+    return res.ec == std::errc() && res.ptr == last;
+}
+
+// Parses a whole real, including "nan"/"inf" spellings, with exact
+// rounding; false on malformed input. Out-of-range magnitudes saturate to
+// infinity or zero like strtod().
+inline bool parse_real(std::string_view str, double& out) {
+    const char* first = str.data();
+    const char* last = first + str.size();
+    if (first != last && *first == '+') ++first;
+    const bool negative = first != last && *first == '-';
+#if LLSD_MODERN_HAS_FLOAT_FROM_CHARS
+    auto res = std::from_chars(first, last, out);
+    if (res.ptr != last) return false;
+    if (res.ec == std::errc()) return true;
+    if (res.ec != std::errc::result_out_of_range) return false;
+#else
+    const char* p = negative ? first + 1 : first;
+    if (last - p == 3 && (std::memcmp(p, "nan", 3) == 0 || std::memcmp(p, "inf", 3) == 0)) {
+        out = *p == 'n' ? std::numeric_limits<double>::quiet_NaN() : std::numeric_limits<double>::infinity();
+        if (negative) out = -out;
+        return true;
+    }
+    std::istringstream ss(std::string(first, last));
+    ss.imbue(std::locale::classic());
+    ss >> out;
+    if (!ss.fail()) return ss.peek() == std::char_traits<char>::eof();
+    // Range errors leave zero or the largest finite value behind
+    if (out != 0 && std::fabs(out) != std::numeric_limits<double>::max()) return false;
+    if (std::string_view(first, last - first).find_first_not_of("+-.0123456789eE") != std::string_view::npos) return false;
+#endif
+    // Underflow iff there is a negative exponent or no non-zero integer digit
+    std::string_view digits(first, last - first);
+    auto exp_pos = digits.find_first_of("eE");
+    bool underflow = exp_pos != std::string_view::npos && exp_pos + 1 < digits.size() && digits[exp_pos + 1] == '-';
+    if (!underflow) {
+        auto int_part = digits.substr(0, std::min(digits.find('.'), exp_pos));
+        underflow = int_part.find_first_not_of("-0") == std::string_view::npos;
+    }
+    out = underflow ? 0.0 : std::numeric_limits<double>::infinity();
+    if (negative) out = -out;
+    return true;
+}
+
+} // namespace detail
+
+// Callback receiving formatted output one chunk at a time
+using ChunkSink = std::function<void(std::string_view)>;
+
+// Forward declaration for the JSON formatter
+std::string format_json(const Value& v);
+void format_json(std::ostream& s, const Value& v);
+void format_json(const ChunkSink& sink, const Value& v, std::size_t chunk_size = 64 * 1024);
+void format_binary(std::ostream& s, const Value& v);
+
+namespace detail {
+
+// Helper to write a big-endian integer
+inline void write_i32_be(std::ostream& s, std::int32_t val) {
+    s.put((val >> 24) & 0xFF);
+    s.put((val >> 16) & 0xFF);
+    s.put((val >> 8) & 0xFF);
+    s.put(val & 0xFF);
+}
+
+// Helper to write a big-endian double
+inline void write_double_be(std::ostream& s, double val) {
     union {
         uint64_t i;
         double d;
@@ -277,6 +1371,159 @@ inline void write_string(std::ostream& s, const std::string& str) {
     s.write(str.data(), str.size());
 }
 
+// Helper to append the base64 encoding of `data` to `out`
+template<typename Out>
+inline void append_base64(Out& out, const std::uint8_t* data, std::size_t size) {
+    static const char* b64 = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    char quad[4];
+    for (std::size_t i = 0; i < size; i += 3) {
+        quad[0] = b64[data[i] >> 2];
+        quad[1] = b64[((data[i] & 0x3) << 4) | (i + 1 < size ? data[i+1] >> 4 : 0)];
+        quad[2] = (i + 1 < size ? b64[((data[i+1] & 0xF) << 2) | (i + 2 < size ? data[i+2] >> 6 : 0)] : '=');
+        quad[3] = (i + 2 < size ? b64[data[i+2] & 0x3F] : '=');
+        out.append(quad, 4);
+    }
+}
+
+// Growable output buffer shared by the text formatters. Without a sink it
+// simply accumulates the whole document; with one, pending bytes are handed
+// to the sink whenever they reach `chunk_size`, so peak memory is bounded by
+// the chunk size rather than by the size of the document.
+class OutputBuffer {
+public:
+    OutputBuffer() = default;
+    OutputBuffer(const ChunkSink& sink, std::size_t chunk_size)
+        : sink_(&sink), chunk_size_(chunk_size ? chunk_size : 1) {
+        buf_.reserve(chunk_size_);
+    }
+
+    void put(char c) {
+        if (sink_ && buf_.size() >= chunk_size_) flush();
+        buf_.push_back(c);
+    }
+
+    void append(const char* p, std::size_t n) {
+        if (sink_ && buf_.size() + n > chunk_size_) {
+            flush();
+            // Runs larger than a whole chunk go straight through
+            if (n >= chunk_size_) {
+                (*sink_)(std::string_view(p, n));
+                return;
+            }
+        }
+        buf_.append(p, n);
+    }
+
+    void append(std::string_view sv) { append(sv.data(), sv.size()); }
+
+    void flush() {
+        if (sink_ && !buf_.empty()) {
+            (*sink_)(std::string_view(buf_));
+            buf_.clear();
+        }
+    }
+
+    std::string& str() { return buf_; }
+
+private:
+    const ChunkSink* sink_ = nullptr;
+    std::size_t chunk_size_ = 0;
+    std::string buf_;
+};
+
+// Helper to write a JSON string literal, copying runs of bytes that need no
+// escaping in bulk. Escapes match nlohmann::json::dump().
+inline void write_json_string(OutputBuffer& out, std::string_view str) {
+    static const char* hex = "0123456789abcdef";
+    out.put('"');
+    const char* p = str.data();
+    const char* end = p + str.size();
+    const char* run = p;
+    for (; p != end; ++p) {
+        unsigned char c = static_cast<unsigned char>(*p);
+        if (c >= 0x20 && c != '"' && c != '\\') continue;
+        out.append(run, p - run);
+        switch (c) {
+            case '"':  out.append("\\\"", 2); break;
+            case '\\': out.append("\\\\", 2); break;
+            case '\b': out.append("\\b", 2); break;
+            case '\f': out.append("\\f", 2); break;
+            case '\n': out.append("\\n", 2); break;
+            case '\r': out.append("\\r", 2); break;
+            case '\t': out.append("\\t", 2); break;
+            default: {
+                const char esc[6] = {'\\', 'u', '0', '0', hex[c >> 4], hex[c & 0xF]};
+                out.append(esc, 6);
+            }
+        }
+        run = p + 1;
+    }
+    out.append(run, p - run);
+    out.put('"');
+}
+
+inline void _format_json_recurse(OutputBuffer& out, const Value& v) {
+    std::visit([&](auto&& arg) {
+        using T = std::decay_t<decltype(arg)>;
+        if constexpr (std::is_same_v<T, Undef>) {
+            out.append("null", 4);
+        } else if constexpr (std::is_same_v<T, bool>) {
+            out.append(arg ? std::string_view("true") : std::string_view("false"));
+        } else if constexpr (std::is_same_v<T, std::int32_t>) {
+            char buf[kNumberBufferSize];
+            out.append(buf, format_integer(buf, arg) - buf);
+        } else if constexpr (std::is_same_v<T, double>) {
+            // NaN and infinities have no JSON representation
+            if (!std::isfinite(arg)) {
+                out.append("null", 4);
+            } else {
+                char buf[kNumberBufferSize];
+                out.append(buf, format_real(buf, arg) - buf);
+            }
+        } else if constexpr (std::is_same_v<T, std::string>) {
+            write_json_string(out, arg);
+        } else if constexpr (std::is_same_v<T, LLUUID>) {
+            char buf[LLUUID::kStringSize + 2];
+            buf[0] = '"';
+            arg.toChars(buf + 1);
+            buf[LLUUID::kStringSize + 1] = '"';
+            out.append(buf, sizeof buf);
+        } else if constexpr (std::is_same_v<T, LLDate>) {
+            write_json_string(out, arg.toString());
+        } else if constexpr (std::is_same_v<T, URI>) {
+            write_json_string(out, arg.s);
+        } else if constexpr (std::is_same_v<T, Binary>) {
+            out.append("\"data:base64,", 13);
+            append_base64(out, arg.b.data(), arg.b.size());
+            out.put('"');
+        } else if constexpr (std::is_same_v<T, std::unique_ptr<Array>>) {
+            out.put('[');
+            if (arg) {
+                bool first = true;
+                for (const auto& item : *arg) {
+                    if (!first) out.put(',');
+                    first = false;
+                    _format_json_recurse(out, item);
+                }
+            }
+            out.put(']');
+        } else if constexpr (std::is_same_v<T, std::unique_ptr<Map>>) {
+            out.put('{');
+            if (arg) {
+                bool first = true;
+                for (const auto& [key, value] : *arg) {
+                    if (!first) out.put(',');
+                    first = false;
+                    write_json_string(out, key);
+                    out.put(':');
+                    _format_json_recurse(out, value);
+                }
+            }
+            out.put('}');
+        }
+    }, v.data);
+}
+
 // Helper for format_json
 nlohmann::json to_json(const Value& v) {
     return std::visit([](auto&& arg) -> nlohmann::json {
@@ -289,15 +1536,9 @@ nlohmann::json to_json(const Value& v) {
             return arg.s;
         } else if constexpr (std::is_same_v<T, Binary>) {
             // JSON doesn't have a binary type, so we'll represent it as a base64 string
-             static const char* b64 = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
              std::string s = "data:base64,";
              s.reserve(s.length() + ((arg.b.size() + 2) / 3) * 4);
-             for (int i = 0; i < arg.b.size(); i += 3) {
-                 s += b64[arg.b[i] >> 2];
-                 s += b64[((arg.b[i] & 0x3) << 4) | (i + 1 < arg.b.size() ? arg.b[i+1] >> 4 : 0)];
-                 s += (i + 1 < arg.b.size() ? b64[((arg.b[i+1] & 0xF) << 2) | (i + 2 < arg.b.size() ? arg.b[i+2] >> 6 : 0)] : '=');
-                 s += (i + 2 < arg.b.size() ? b64[arg.b[i+2] & 0x3F] : '=');
-             }
+             append_base64(s, arg.b.data(), arg.b.size());
              return s;
         } else if constexpr (std::is_same_v<T, std::unique_ptr<Array>>) {
             nlohmann::json arr = nlohmann::json::array();
@@ -324,17 +1565,168 @@ nlohmann::json to_json(const Value& v) {
 
 
 inline std::string format_json(const Value& v) {
-    return detail::to_json(v).dump();
+    detail::OutputBuffer out;
+    detail::_format_json_recurse(out, v);
+    return std::move(out.str());
+}
+
+// Writes JSON to `s` through a bounded buffer instead of building the whole
+// document in memory first.
+inline void format_json(std::ostream& s, const Value& v) {
+    ChunkSink sink = [&s](std::string_view chunk) { s.write(chunk.data(), chunk.size()); };
+    format_json(sink, v);
+}
+
+// Writes JSON through `sink`, handing it at most `chunk_size` buffered bytes
+// at a time (longer runs, such as a single huge string, are passed through).
+inline void format_json(const ChunkSink& sink, const Value& v, std::size_t chunk_size) {
+    detail::OutputBuffer out(sink, chunk_size);
+    detail::_format_json_recurse(out, v);
+    out.flush();
+}
+
+namespace detail {
+
+// Helper to decode the payload of a non-container binary token
+inline Value read_binary_scalar(std::istream& s, char type_char) {
+    switch (type_char) {
+        case '!': return Value(Undef{});
+        case '0': return Value(false);
+        case '1': return Value(true);
+        case 'i': return Value(read_i32_be(s));
+        case 'r': return Value(read_double_be(s));
+        case 'u': {
+            auto bytes = read_bytes(s, 16);
+            std::array<std::uint8_t, 16> uuid_bytes;
+            std::copy(bytes.begin(), bytes.end(), uuid_bytes.begin());
+            return Value(LLUUID(uuid_bytes));
+        }
+        case 's': return Value(read_string(s));
+        case 'l': return Value(URI{read_string(s)});
+        case 'd': {
+             auto seconds_double = read_double_le(s);
+             auto duration = std::chrono::duration<double>(seconds_double);
+             auto time_point = std::chrono::system_clock::time_point(std::chrono::round<std::chrono::system_clock::duration>(duration));
+             return Value(LLDate(time_point));
+        }
+        case 'b': {
+            auto size = read_i32_be(s);
+            if (size < 0) throw std::runtime_error("Invalid binary size");
+            auto bytes = read_bytes(s, size);
+            std::vector<std::uint8_t> binary_data(bytes.begin(), bytes.end());
+            return Value(Binary{binary_data});
+        }
+        default:
+            throw std::runtime_error("Invalid binary token");
+    }
+}
+
+// Read-only streambuf over a caller-owned buffer, for running the stream
+// based parsers over memory without copying it into a stringstream
+class ViewStreambuf : public std::streambuf {
+public:
+    explicit ViewStreambuf(std::string_view data) {
+        char* p = const_cast<char*>(data.data());
+        setg(p, p, p + data.size());
+    }
+};
+
+// Write-only streambuf appending to a caller-owned string, so stream based
+// formatters can fill a string without an intermediate copy
+class StringSinkStreambuf : public std::streambuf {
+public:
+    explicit StringSinkStreambuf(std::string& out) : out_(out) {}
+
+protected:
+    int_type overflow(int_type c) override {
+        if (!traits_type::eq_int_type(c, traits_type::eof())) out_.push_back(traits_type::to_char_type(c));
+        return traits_type::not_eof(c);
+    }
+    std::streamsize xsputn(const char* s, std::streamsize n) override {
+        out_.append(s, static_cast<std::size_t>(n));
+        return n;
+    }
+
+private:
+    std::string& out_;
+};
+
+// Caps an untrusted element count before reserving, as the compact parser
+// does: no more elements than the stream's buffered input could hold at
+// `min_size` bytes each, or a small fixed number when it holds fewer, so a
+// bogus count cannot force a huge allocation up front
+inline std::size_t plausible_count(std::istream& s, std::int32_t count, std::size_t min_size) {
+    if (count <= 0) return 0;
+    std::streamsize avail = s.rdbuf()->in_avail();
+    std::size_t cap = std::max<std::size_t>(avail > 0 ? static_cast<std::size_t>(avail) / min_size : 0, 64);
+    return std::min<std::size_t>(static_cast<std::size_t>(count), cap);
 }
 
+// Helper to decode a big-endian int32 or double payload
+template <typename T>
+T load_be(const char* p) {
+    using U = std::conditional_t<sizeof(T) == 8, std::uint64_t, std::uint32_t>;
+    U u = 0;
+    for (std::size_t b = 0; b < sizeof(T); ++b) u = (u << 8) | static_cast<unsigned char>(p[b]);
+    T v;
+    std::memcpy(&v, &u, sizeof(T));
+    return v;
+}
+
+// Reads the leading run of up to `size` 'r' (double) or 'i' (int32) tokens
+// of an array into `packed`, returning how many were read. The big-endian
+// payloads are copied as-is and byte-swapped afterwards in one pass over
+// contiguous memory, which the compiler vectorizes.
+template <typename T>
+int read_packed_run(std::istream& s, int size, std::vector<T>& packed) {
+    constexpr char token = std::is_same_v<T, double> ? 'r' : 'i';
+    packed.clear();
+    packed.reserve(plausible_count(s, size, 1 + sizeof(T)));
+    std::streambuf* buf = s.rdbuf();
+    char record[1 + sizeof(T)];
+    while (static_cast<int>(packed.size()) < size && buf->sgetc() == token) {
+        if (buf->sgetn(record, sizeof record) != static_cast<std::streamsize>(sizeof record)) {
+            s.setstate(std::ios::eofbit | std::ios::failbit);
+            throw std::runtime_error("Unexpected end of stream");
+        }
+        packed.emplace_back();
+        std::memcpy(&packed.back(), record + 1, sizeof(T));
+    }
+    for (T& v : packed) v = load_be<T>(reinterpret_cast<const char*>(&v));
+    return static_cast<int>(packed.size());
+}
+
+// Reads a leading run of numbers as read_packed_run does, but straight into
+// `array`'s Values, one whole record per streambuf call instead of a
+// parse_binary call per element
+template <typename T>
+int read_numeric_run(std::istream& s, int size, Array& array) {
+    constexpr char token = std::is_same_v<T, double> ? 'r' : 'i';
+    std::streambuf* buf = s.rdbuf();
+    char record[1 + sizeof(T)];
+    int count = 0;
+    while (count < size && buf->sgetc() == token) {
+        if (buf->sgetn(record, sizeof record) != static_cast<std::streamsize>(sizeof record)) {
+            s.setstate(std::ios::eofbit | std::ios::failbit);
+            throw std::runtime_error("Unexpected end of stream");
+        }
+        array.emplace_back(load_be<T>(record + 1));
+        ++count;
+    }
+    return count;
+}
+
+} // namespace detail
+
 inline Value parse_binary(std::istream& s) {
-    char type_char;
+    char type_char = 0;
     s.get(type_char);
 
     switch (type_char) {
         case '{': {
             auto map = std::make_unique<Map>();
             auto size = detail::read_i32_be(s);
+            if (size > 0) map->reserve(size);
             for (int i = 0; i < size; ++i) {
                 s.get(type_char);
                 if (type_char != 'k') throw std::runtime_error("Expected 'k' for map key");
@@ -348,46 +1740,49 @@ inline Value parse_binary(std::istream& s) {
         case '[': {
             auto array = std::make_unique<Array>();
             auto size = detail::read_i32_be(s);
-            array->reserve(size);
-            for (int i = 0; i < size; ++i) {
+            array->reserve(detail::plausible_count(s, size, 1));
+            int i = 0;
+            if (size > 0) {
+                int next = s.peek();
+                if (next == 'r') i = detail::read_numeric_run<double>(s, size, *array);
+                else if (next == 'i') i = detail::read_numeric_run<std::int32_t>(s, size, *array);
+            }
+            for (; i < size; ++i) {
                 array->push_back(parse_binary(s));
             }
             s.get(type_char);
             if (type_char != ']') throw std::runtime_error("Expected ']' to close array");
             return Value(std::move(array));
         }
-        case '!': return Value(Undef{});
-        case '0': return Value(false);
-        case '1': return Value(true);
-        case 'i': return Value(detail::read_i32_be(s));
-        case 'r': return Value(detail::read_double_be(s));
-        case 'u': {
-            auto bytes = detail::read_bytes(s, 16);
-            std::array<std::uint8_t, 16> uuid_bytes;
-            std::copy(bytes.begin(), bytes.end(), uuid_bytes.begin());
-            return Value(LLUUID(uuid_bytes));
-        }
-        case 's': return Value(detail::read_string(s));
-        case 'l': return Value(URI{detail::read_string(s)});
-        case 'd': {
-             auto seconds_double = detail::read_double_le(s);
-             auto duration = std::chrono::duration<double>(seconds_double);
-             auto time_point = std::chrono::system_clock::time_point(std::chrono::duration_cast<std::chrono::system_clock::duration>(duration));
-             return Value(LLDate(time_point));
-        }
-        case 'b': {
-            auto size = detail::read_i32_be(s);
-            if (size < 0) throw std::runtime_error("Invalid binary size");
-            auto bytes = detail::read_bytes(s, size);
-            std::vector<std::uint8_t> binary_data(bytes.begin(), bytes.end());
-            return Value(Binary{binary_data});
-        }
         default:
-            throw std::runtime_error("Invalid binary token");
+            return detail::read_binary_scalar(s, type_char);
     }
 }
 
 namespace detail {
+    // Writes packed numbers as 'r' or 'i' tokens, a block at a time
+    template <typename Packed>
+    void write_packed_run(std::ostream& s, const Packed& packed) {
+        using T = typename Packed::value_type;
+        constexpr std::size_t kRecord = 1 + sizeof(T);
+        constexpr std::size_t kBlock = 256;
+        using U = std::conditional_t<sizeof(T) == 8, std::uint64_t, std::uint32_t>;
+        char buf[kRecord * kBlock];
+        for (std::size_t i = 0; i < packed.size(); i += kBlock) {
+            std::size_t n = std::min(kBlock, packed.size() - i);
+            for (std::size_t j = 0; j < n; ++j) {
+                char* record = buf + j * kRecord;
+                U u;
+                std::memcpy(&u, &packed[i + j], sizeof(T));
+                record[0] = std::is_same_v<T, double> ? 'r' : 'i';
+                for (std::size_t b = 0; b < sizeof(T); ++b) {
+                    record[1 + b] = static_cast<char>(u >> (8 * (sizeof(T) - 1 - b)));
+                }
+            }
+            s.write(buf, n * kRecord);
+        }
+    }
+
     inline void _format_binary_recurse(std::ostream& s, const Value& v) {
         std::visit([&](auto&& arg) {
             using T = std::decay_t<decltype(arg)>;
@@ -451,22 +1846,93 @@ inline void format_binary(std::ostream& s, const Value& v) {
     detail::_format_binary_recurse(s, v);
 }
 
+namespace detail {
+
+inline void _binary_to_json_recurse(std::istream& s, OutputBuffer& out) {
+    char type_char = 0;
+    s.get(type_char);
+    switch (type_char) {
+        case '{': {
+            auto size = read_i32_be(s);
+            out.put('{');
+            for (int i = 0; i < size; ++i) {
+                s.get(type_char);
+                if (type_char != 'k') throw std::runtime_error("Expected 'k' for map key");
+                if (i) out.put(',');
+                write_json_string(out, read_string(s));
+                out.put(':');
+                _binary_to_json_recurse(s, out);
+            }
+            s.get(type_char);
+            if (type_char != '}') throw std::runtime_error("Expected '}' to close map");
+            out.put('}');
+            break;
+        }
+        case '[': {
+            auto size = read_i32_be(s);
+            out.put('[');
+            for (int i = 0; i < size; ++i) {
+                if (i) out.put(',');
+                _binary_to_json_recurse(s, out);
+            }
+            s.get(type_char);
+            if (type_char != ']') throw std::runtime_error("Expected ']' to close array");
+            out.put(']');
+            break;
+        }
+        default:
+            _format_json_recurse(out, read_binary_scalar(s, type_char));
+    }
+}
+
+} // namespace detail
+
+// Transcodes one binary LLSD document straight to JSON without building a
+// Value or nlohmann::json tree. The output matches format_json(parse_binary())
+// for documents written by format_binary; map keys are emitted in stream
+// order, so other producers' unsorted or duplicate keys pass through as-is.
+inline void binary_to_json(std::istream& in, const ChunkSink& sink, std::size_t chunk_size = 64 * 1024) {
+    detail::OutputBuffer out(sink, chunk_size);
+    detail::_binary_to_json_recurse(in, out);
+    out.flush();
+}
+
+inline void binary_to_json(std::istream& in, std::ostream& out) {
+    ChunkSink sink = [&out](std::string_view chunk) { out.write(chunk.data(), chunk.size()); };
+    binary_to_json(in, sink);
+}
+
+inline std::string binary_to_json(std::string_view binary) {
+    detail::ViewStreambuf buf(binary);
+    std::istream in(&buf);
+    detail::OutputBuffer out;
+    detail::_binary_to_json_recurse(in, out);
+    return std::move(out.str());
+}
+
 // Forward declaration for the JSON parser
-Value parse_json(const std::string& s);
+Value parse_json(std::string_view s);
+Value parse_json(std::istream& s);
 
 namespace detail {
     // Helper to decode a base64 string
-    inline std::vector<std::uint8_t> from_base64(const std::string& s) {
-        static const std::string b64 = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
-        std::vector<int> T(256, -1);
-        for (int i = 0; i < 64; i++) T[b64[i]] = i;
+    inline std::vector<std::uint8_t> from_base64(std::string_view s) {
+        static const auto T = [] {
+            static const std::string b64 = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+            std::array<int, 256> table;
+            table.fill(-1);
+            for (int i = 0; i < 64; i++) table[static_cast<unsigned char>(b64[i])] = i;
+            return table;
+        }();
 
         std::vector<std::uint8_t> out;
+        out.reserve(s.size() / 4 * 3);
         int val = 0, valb = -8;
         for (char c : s) {
             if (c == '=') break;
-            if (T[c] == -1) continue;
-            val = (val << 6) + T[c];
+            int d = T[static_cast<unsigned char>(c)];
+            if (d == -1) continue;
+            val = (val << 6) + d;
             valb += 6;
             if (valb >= 0) {
                 out.push_back(static_cast<std::uint8_t>((val >> valb) & 0xFF));
@@ -476,45 +1942,64 @@ namespace detail {
         return out;
     }
 
+    // Helper to parse a canonical lowercase UUID string
+    inline bool parse_uuid_string(std::string_view s, LLUUID& out) {
+        // Only the lowercase form written by format_json is taken for a UUID
+        std::array<std::uint8_t, 16> bytes;
+        if (!decode_uuid(s, bytes, true)) return false;
+        out = LLUUID(bytes);
+        return true;
+    }
+
+    // Helper to parse a UTC ISO-8601 date string
+    inline bool parse_date_string(std::string_view s, LLDate& out) {
+        auto date = LLDate::parse(s);
+        if (!date) return false;
+        out = *date;
+        return true;
+    }
+
+    // Helper to map a JSON string onto the LLSD type it encodes: base64
+    // binary, UUID, date, or a plain string
+    inline Value from_json_string(std::string s) {
+        // Try to match base64 binary
+        if (s.rfind("data:base64,", 0) == 0) {
+            return Value(Binary{from_base64(s.substr(12))});
+        }
+        // Try to match UUID
+        LLUUID uuid;
+        if (parse_uuid_string(s, uuid)) {
+            return Value(uuid);
+        }
+        // Try to match Date
+        LLDate date;
+        if (parse_date_string(s, date)) {
+            return Value(date);
+        }
+        return Value(std::move(s));
+    }
+
+    // JSON integers outside the int32 range become reals rather than wrapping
+    template <typename T>
+    inline Value from_json_integer(T val) {
+        bool fits = val <= static_cast<T>(std::numeric_limits<std::int32_t>::max());
+        if constexpr (std::is_signed_v<T>) fits = fits && val >= std::numeric_limits<std::int32_t>::min();
+        return fits ? Value(static_cast<std::int32_t>(val)) : Value(static_cast<double>(val));
+    }
+
     inline Value from_json(const nlohmann::json& j) {
         if (j.is_null()) {
             return Value(Undef{});
         } else if (j.is_boolean()) {
             return Value(j.get<bool>());
+        } else if (j.is_number_unsigned()) {
+            return from_json_integer(j.get<std::uint64_t>());
         } else if (j.is_number_integer()) {
-            return Value(j.get<std::int32_t>());
+            return from_json_integer(j.get<std::int64_t>());
         } else if (j.is_number_float()) {
             return Value(j.get<double>());
         } else if (j.is_string()) {
-            const std::string s = j.get<std::string>();
-            // Try to match base64 binary
-            if (s.rfind("data:base64,", 0) == 0) {
-                return Value(Binary{from_base64(s.substr(12))});
-            }
-            // Try to match UUID
-            static const std::regex uuid_re("^[0-9a-f]{8}-[0-9a-f]{4}-[0-9a-f]{4}-[0-9a-f]{4}-[0-9a-f]{12}$");
-            if (std::regex_match(s, uuid_re)) {
-                std::string hex_str = s;
-                hex_str.erase(std::remove(hex_str.begin(), hex_str.end(), '-'), hex_str.end());
-                std::array<std::uint8_t, 16> bytes;
-                for(int i=0; i<16; ++i) {
-                    bytes[i] = std::stoi(hex_str.substr(i*2, 2), nullptr, 16);
-                }
-                return Value(LLUUID(bytes));
-            }
-            // Try to match Date
-            static const std::regex date_re("^\\d{4}-\\d{2}-\\d{2}T\\d{2}:\\d{2}:\\d{2}Z$");
-            if (std::regex_match(s, date_re)) {
-                std::tm tm = {};
-                std::stringstream ss(s);
-                ss >> std::get_time(&tm, "%Y-%m-%dT%H:%M:%SZ");
-                #ifdef _WIN32
-                    static constexpr auto& timegm = _mkgmtime;
-                #endif
-                auto time_point = std::chrono::system_clock::from_time_t(timegm(&tm));
-                return Value(LLDate(time_point));
-            }
-            return Value(s);
+            return from_json_string(j.get<std::string>());
         } else if (j.is_array()) {
             auto array = std::make_unique<Array>();
             for (const auto& item : j) {
@@ -523,6 +2008,7 @@ namespace detail {
             return Value(std::move(array));
         } else if (j.is_object()) {
             auto map = std::make_unique<Map>();
+            map->reserve(j.size());
             for (auto it = j.begin(); it != j.end(); ++it) {
                 (*map)[it.key()] = from_json(it.value());
             }
@@ -533,9 +2019,2106 @@ namespace detail {
 
 }
 
-inline Value parse_json(const std::string& s) {
+inline Value parse_json(std::string_view s) {
+    nlohmann::json j = nlohmann::json::parse(s.data(), s.data() + s.size());
+    return detail::from_json(j);
+}
+
+inline Value parse_json(std::istream& s) {
     nlohmann::json j = nlohmann::json::parse(s);
     return detail::from_json(j);
 }
 
-} // namespace llsd_modern
+// How json_to_binary() orders map entries: as they appear in the input, or
+// sorted by key with only the last of any duplicates kept, which is what
+// format_binary(parse_json(...)) writes
+enum class KeyOrder { Input, Sorted };
+
+namespace detail {
+
+// SAX handler that writes binary LLSD as JSON tokens arrive. Container sizes
+// are not known up front, so a placeholder is written and back-patched when
+// the container closes; only one entry per open container is kept. With
+// KeyOrder::Sorted, everything inside an open map is buffered instead, and
+// each map is rewritten in key order when it closes.
+class JsonToBinarySax : public nlohmann::json_sax<nlohmann::json> {
+public:
+    explicit JsonToBinarySax(std::ostream& s, KeyOrder order = KeyOrder::Input)
+        : s_(s), sorted_(order == KeyOrder::Sorted), buffer_sink_(buffer_), buffer_stream_(&buffer_sink_) {}
+
+    bool null() override { return scalar(Value(Undef{})); }
+    bool boolean(bool val) override { return scalar(Value(val)); }
+    bool number_integer(number_integer_t val) override { return scalar(from_json_integer(val)); }
+    bool number_unsigned(number_unsigned_t val) override { return scalar(from_json_integer(val)); }
+    bool number_float(number_float_t val, const string_t&) override { return scalar(Value(val)); }
+    bool string(string_t& val) override { return scalar(from_json_string(std::move(val))); }
+    bool binary(binary_t& val) override { return scalar(Value(Binary{std::vector<std::uint8_t>(val.begin(), val.end())})); }
+
+    bool start_object(std::size_t) override {
+        count_element();
+        if (!sorted_) return open('{');
+        open_.push_back({std::streampos(-1), buffer_.size(), entries_.size(), 0, '}'});
+        ++maps_;
+        return true;
+    }
+    bool key(string_t& val) override {
+        if (sorted_) {
+            // The raw key is buffered in front of its value until the map
+            // closes
+            entries_.push_back({buffer_.size(), val.size(), 0});
+            buffer_.append(val);
+            return true;
+        }
+        ++open_.back().count;
+        s_.put('k');
+        write_string(s_, val);
+        return true;
+    }
+    bool end_object() override {
+        if (sorted_) {
+            close_sorted_map();
+        } else {
+            close();
+        }
+        return true;
+    }
+    bool start_array(std::size_t) override {
+        count_element();
+        return open('[');
+    }
+    bool end_array() override {
+        close();
+        return true;
+    }
+
+    bool parse_error(std::size_t, const std::string&, const nlohmann::detail::exception& ex) override {
+        throw std::runtime_error(ex.what());
+    }
+
+private:
+    struct OpenContainer {
+        std::streampos size_pos;  // Size placeholder in the output, or -1
+        std::size_t offset;       // Size placeholder or sorted map in buffer_
+        std::size_t first_entry;
+        std::int32_t count;
+        char close;
+    };
+
+    // A buffered map entry: its raw key, followed by its value up to `end`
+    struct Entry {
+        std::size_t key;
+        std::size_t key_size;
+        std::size_t end;
+    };
+
+    std::ostream& target() { return maps_ ? buffer_stream_ : s_; }
+
+    void count_element() {
+        if (!open_.empty() && open_.back().close == ']') ++open_.back().count;
+    }
+
+    bool scalar(const Value& v) {
+        count_element();
+        _format_binary_recurse(target(), v);
+        return true;
+    }
+
+    bool open(char token) {
+        std::ostream& out = target();
+        out.put(token);
+        OpenContainer container{std::streampos(-1), buffer_.size(), 0, 0, token == '[' ? ']' : '}'};
+        if (!maps_) {
+            container.size_pos = s_.tellp();
+            if (container.size_pos == std::streampos(-1)) {
+                throw std::runtime_error("JSON to binary transcoding requires a seekable output stream");
+            }
+        }
+        write_i32_be(out, 0);
+        open_.push_back(container);
+        return true;
+    }
+
+    void close() {
+        const OpenContainer& container = open_.back();
+        if (container.size_pos == std::streampos(-1)) {
+            auto count = static_cast<std::uint32_t>(container.count);
+            for (int i = 0; i < 4; ++i) buffer_[container.offset + i] = static_cast<char>(count >> (24 - 8 * i));
+        } else {
+            auto end = s_.tellp();
+            s_.seekp(container.size_pos);
+            write_i32_be(s_, container.count);
+            s_.seekp(end);
+        }
+        char token = container.close;
+        open_.pop_back();
+        target().put(token);
+    }
+
+    // Rewrites the innermost map's buffered entries in key order, the last
+    // of any duplicates winning as in parse_json, in place of the entries
+    void close_sorted_map() {
+        OpenContainer map = open_.back();
+        open_.pop_back();
+        auto first = entries_.begin() + static_cast<std::ptrdiff_t>(map.first_entry);
+        for (auto it = first; it != entries_.end(); ++it) {
+            it->end = it + 1 != entries_.end() ? (it + 1)->key : buffer_.size();
+        }
+        auto key_of = [this](const Entry& e) { return std::string_view(buffer_.data() + e.key, e.key_size); };
+        std::stable_sort(first, entries_.end(), [&](const Entry& a, const Entry& b) { return key_of(a) < key_of(b); });
+        auto last = first;
+        for (auto it = first; it != entries_.end(); ++it) {
+            if (last != first && key_of(*(last - 1)) == key_of(*it)) {
+                *(last - 1) = *it;
+            } else {
+                *last++ = *it;
+            }
+        }
+
+        // Assembled in a scratch string reused across maps
+        sorted_map_.clear();
+        StringSinkStreambuf sink(sorted_map_);
+        std::ostream out(&sink);
+        out.put('{');
+        write_i32_be(out, static_cast<std::int32_t>(last - first));
+        for (auto it = first; it != last; ++it) {
+            out.put('k');
+            write_i32_be(out, static_cast<std::int32_t>(it->key_size));
+            sorted_map_.append(buffer_, it->key, it->end - it->key);
+        }
+        out.put('}');
+        entries_.erase(first, entries_.end());
+
+        if (--maps_ == 0) {
+            s_.write(sorted_map_.data(), static_cast<std::streamsize>(sorted_map_.size()));
+            buffer_.clear();
+        } else {
+            buffer_.replace(map.offset, std::string::npos, sorted_map_);
+        }
+    }
+
+    std::ostream& s_;
+    bool sorted_;
+    std::vector<OpenContainer> open_;
+    std::vector<Entry> entries_;
+    std::size_t maps_ = 0; // Sorted maps open; while nonzero, output is buffered
+    std::string buffer_;
+    std::string sorted_map_;
+    StringSinkStreambuf buffer_sink_;
+    std::ostream buffer_stream_;
+};
+
+} // namespace detail
+
+// Transcodes a JSON document straight to binary LLSD without building either
+// an nlohmann::json or a Value tree, applying the same string and integer
+// conversions as parse_json. Map entries keep their input order, duplicates
+// included, so memory use is bounded by nesting depth rather than document
+// size; parse_binary reads the result back as parse_json would read the
+// input. KeyOrder::Sorted instead gives exactly format_binary(parse_json(...))
+// at the cost of buffering each outermost map whole, and copying it once per
+// level of nesting. `out` must be seekable, since container sizes are
+// back-patched.
+inline void json_to_binary(std::istream& in, std::ostream& out, KeyOrder order = KeyOrder::Input) {
+    detail::JsonToBinarySax sax(out, order);
+    nlohmann::json::sax_parse(in, &sax);
+}
+
+inline std::string json_to_binary(std::string_view json, KeyOrder order = KeyOrder::Input) {
+    std::ostringstream out(std::ios::out | std::ios::binary);
+    detail::JsonToBinarySax sax(out, order);
+    nlohmann::json::sax_parse(json.data(), json.data() + json.size(), &sax);
+    return std::move(out).str();
+}
+
+// Forward declaration for the XML parser
+Value parse_xml(std::string_view s);
+
+namespace detail {
+
+// Helper to find the first '<', '&' or '\r' in [p, end): the bytes that end
+// a run of XML character data that can be taken verbatim
+inline const char* find_xml_special(const char* p, const char* end) {
+#if LLSD_MODERN_HAS_SSE2
+    const __m128i lt = _mm_set1_epi8('<');
+    const __m128i amp = _mm_set1_epi8('&');
+    const __m128i cr = _mm_set1_epi8('\r');
+    for (; end - p >= 16; p += 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i hits = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, lt), _mm_cmpeq_epi8(chunk, amp)),
+                                    _mm_cmpeq_epi8(chunk, cr));
+        int mask = _mm_movemask_epi8(hits);
+        if (mask) {
+#if defined(_MSC_VER) && !defined(__clang__)
+            unsigned long index;
+            _BitScanForward(&index, static_cast<unsigned long>(mask));
+            return p + index;
+#else
+            return p + __builtin_ctz(static_cast<unsigned>(mask));
+#endif
+        }
+    }
+#endif
+    for (; p != end; ++p) {
+        if (*p == '<' || *p == '&' || *p == '\r') return p;
+    }
+    return end;
+}
+
+// Helper to append a code point to `out` as UTF-8
+inline void append_utf8(std::string& out, std::uint32_t cp) {
+    if (cp < 0x80) {
+        out += static_cast<char>(cp);
+    } else if (cp < 0x800) {
+        out += static_cast<char>(0xC0 | (cp >> 6));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    } else if (cp < 0x10000) {
+        out += static_cast<char>(0xE0 | (cp >> 12));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    } else {
+        out += static_cast<char>(0xF0 | (cp >> 18));
+        out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    }
+}
+
+// Helper to decode a base16 string, ignoring whitespace
+inline std::vector<std::uint8_t> from_base16(std::string_view s) {
+    std::vector<std::uint8_t> out;
+    out.reserve(s.size() / 2);
+    int hi = -1;
+    for (char c : s) {
+        int d;
+        if (c >= '0' && c <= '9') d = c - '0';
+        else if (c >= 'a' && c <= 'f') d = c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F') d = c - 'A' + 10;
+        else if (c == ' ' || c == '\t' || c == '\n' || c == '\r') continue;
+        else throw std::runtime_error("Invalid base16 data");
+        if (hi < 0) {
+            hi = d;
+        } else {
+            out.push_back(static_cast<std::uint8_t>((hi << 4) | d));
+            hi = -1;
+        }
+    }
+    if (hi >= 0) throw std::runtime_error("Invalid base16 data");
+    return out;
+}
+
+inline std::string_view trim_xml_space(std::string_view s) {
+    auto first = s.find_first_not_of(" \t\r\n");
+    if (first == std::string_view::npos) return std::string_view();
+    return s.substr(first, s.find_last_not_of(" \t\r\n") - first + 1);
+}
+
+// Non-DOM scanner for LLSD XML. Elements are consumed in a single forward
+// pass straight into Values; character data without entities, CDATA or
+// carriage returns is handed out as a view into the input.
+class XmlParser {
+public:
+    explicit XmlParser(std::string_view xml) : p_(xml.data()), end_(xml.data() + xml.size()) {}
+
+    Value parse_document() {
+        skip_misc();
+        Tag root = read_open_tag();
+        if (root.name != "llsd") fail("expected <llsd> root element");
+        Value result;
+        if (!root.self_closing) {
+            skip_misc();
+            if (!at_close_tag()) {
+                result = parse_value();
+                skip_misc();
+            }
+            read_close_tag("llsd");
+        }
+        skip_misc();
+        if (p_ != end_) fail("unexpected content after </llsd>");
+        return result;
+    }
+
+private:
+    struct Tag {
+        std::string_view name;
+        std::string_view encoding;
+        bool self_closing = false;
+    };
+
+    [[noreturn]] void fail(const char* what) const {
+        throw std::runtime_error(std::string("Invalid LLSD XML: ") + what);
+    }
+
+    bool starts_with(std::string_view prefix) const {
+        return static_cast<std::size_t>(end_ - p_) >= prefix.size() &&
+               std::memcmp(p_, prefix.data(), prefix.size()) == 0;
+    }
+
+    static bool is_space(char c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r'; }
+
+    void skip_space() {
+        while (p_ != end_ && is_space(*p_)) ++p_;
+    }
+
+    void skip_past(std::string_view terminator) {
+        auto rest = std::string_view(p_, end_ - p_);
+        auto pos = rest.find(terminator);
+        if (pos == std::string_view::npos) fail("unterminated markup");
+        p_ += pos + terminator.size();
+    }
+
+    // Skips whitespace, comments, processing instructions and declarations
+    void skip_misc() {
+        for (;;) {
+            skip_space();
+            if (starts_with("<?")) skip_past("?>");
+            else if (starts_with("<!--")) skip_past("-->");
+            else if (starts_with("<!") && !starts_with("<![CDATA[")) skip_past(">");
+            else return;
+        }
+    }
+
+    bool at_close_tag() const { return starts_with("</"); }
+
+    std::string_view read_name() {
+        const char* start = p_;
+        while (p_ != end_ && !is_space(*p_) && *p_ != '>' && *p_ != '/' && *p_ != '=') ++p_;
+        if (p_ == start) fail("expected a name");
+        return std::string_view(start, p_ - start);
+    }
+
+    Tag read_open_tag() {
+        if (p_ == end_ || *p_ != '<' || at_close_tag()) fail("expected an element");
+        ++p_;
+        Tag tag;
+        tag.name = read_name();
+        for (;;) {
+            skip_space();
+            if (p_ == end_) fail("unterminated tag");
+            if (*p_ == '>') {
+                ++p_;
+                return tag;
+            }
+            if (*p_ == '/') {
+                if (++p_ == end_ || *p_ != '>') fail("malformed empty-element tag");
+                ++p_;
+                tag.self_closing = true;
+                return tag;
+            }
+            auto attr = read_name();
+            skip_space();
+            if (p_ == end_ || *p_ != '=') fail("expected '=' after attribute name");
+            ++p_;
+            skip_space();
+            if (p_ == end_ || (*p_ != '"' && *p_ != '\'')) fail("expected quoted attribute value");
+            char quote = *p_++;
+            const char* start = p_;
+            while (p_ != end_ && *p_ != quote) ++p_;
+            if (p_ == end_) fail("unterminated attribute value");
+            if (attr == "encoding") tag.encoding = std::string_view(start, p_ - start);
+            ++p_;
+        }
+    }
+
+    void read_close_tag(std::string_view name) {
+        if (!at_close_tag()) fail("expected a closing tag");
+        p_ += 2;
+        if (read_name() != name) fail("mismatched closing tag");
+        skip_space();
+        if (p_ == end_ || *p_ != '>') fail("unterminated closing tag");
+        ++p_;
+    }
+
+    void decode_entity(std::string& out) {
+        const char* semi = static_cast<const char*>(std::memchr(p_, ';', std::min<std::ptrdiff_t>(end_ - p_, 12)));
+        if (!semi) fail("unterminated entity reference");
+        std::string_view name(p_ + 1, semi - p_ - 1);
+        if (name == "lt") out += '<';
+        else if (name == "gt") out += '>';
+        else if (name == "amp") out += '&';
+        else if (name == "quot") out += '"';
+        else if (name == "apos") out += '\'';
+        else if (name.size() > 1 && name[0] == '#') {
+            std::uint32_t cp = 0;
+            bool hex = name[1] == 'x';
+            auto digits = name.substr(hex ? 2 : 1);
+            auto res = std::from_chars(digits.data(), digits.data() + digits.size(), cp, hex ? 16 : 10);
+            if (digits.empty() || res.ec != std::errc() || res.ptr != digits.data() + digits.size() || cp > 0x10FFFF) {
+                fail("invalid character reference");
+            }
+            append_utf8(out, cp);
+        } else {
+            fail("unknown entity");
+        }
+        p_ = semi + 1;
+    }
+
+    // Reads character data up to `</name>`. The returned view points into
+    // the input when possible, or into `scratch` when decoding was needed.
+    std::string_view read_text(std::string_view name, std::string& scratch) {
+        const char* start = p_;
+        p_ = find_xml_special(p_, end_);
+        if (p_ != end_ && *p_ == '<' && at_close_tag()) {
+            std::string_view text(start, p_ - start);
+            read_close_tag(name);
+            return text;
+        }
+        // Slow path: entities, CDATA, comments or line-end normalization
+        scratch.assign(start, p_ - start);
+        for (;;) {
+            if (p_ == end_) fail("unterminated element");
+            if (*p_ == '&') {
+                decode_entity(scratch);
+            } else if (*p_ == '\r') {
+                scratch += '\n';
+                if (++p_ != end_ && *p_ == '\n') ++p_;
+            } else if (starts_with("<![CDATA[")) {
+                p_ += 9;
+                const char* cdata = p_;
+                skip_past("]]>");
+                scratch.append(cdata, p_ - 3 - cdata);
+            } else if (starts_with("<!--")) {
+                skip_past("-->");
+            } else if (at_close_tag()) {
+                read_close_tag(name);
+                return scratch;
+            } else {
+                fail("unexpected element in character data");
+            }
+            const char* run = p_;
+            p_ = find_xml_special(p_, end_);
+            scratch.append(run, p_ - run);
+        }
+    }
+
+    Value parse_value() {
+        Tag tag = read_open_tag();
+        const auto name = tag.name;
+        if (name == "map") {
+            auto map = std::make_unique<Map>();
+            if (!tag.self_closing) {
+                for (;;) {
+                    skip_misc();
+                    if (at_close_tag()) break;
+                    Tag key_tag = read_open_tag();
+                    if (key_tag.name != "key") fail("expected <key> in <map>");
+                    std::string key;
+                    if (!key_tag.self_closing) key = std::string(read_text("key", scratch_));
+                    skip_misc();
+                    (*map)[std::move(key)] = parse_value();
+                }
+                read_close_tag("map");
+            }
+            return Value(std::move(map));
+        }
+        if (name == "array") {
+            auto array = std::make_unique<Array>();
+            if (!tag.self_closing) {
+                for (;;) {
+                    skip_misc();
+                    if (at_close_tag()) break;
+                    array->push_back(parse_value());
+                }
+                read_close_tag("array");
+            }
+            return Value(std::move(array));
+        }
+
+        std::string_view text;
+        if (!tag.self_closing) text = read_text(name, scratch_);
+
+        if (name == "string") return Value(std::string(text));
+        if (name == "undef") return Value(Undef{});
+        if (name == "integer") {
+            auto t = trim_xml_space(text);
+            std::int32_t i = 0;
+            if (!t.empty() && !parse_integer(t, i)) fail("invalid <integer>");
+            return Value(i);
+        }
+        if (name == "real") {
+            auto t = trim_xml_space(text);
+            double r = 0.0;
+            if (!t.empty() && !parse_real(t, r)) fail("invalid <real>");
+            return Value(r);
+        }
+        if (name == "boolean") {
+            auto t = trim_xml_space(text);
+            return Value(t == "1" || t == "true");
+        }
+        if (name == "uuid") {
+            auto t = trim_xml_space(text);
+            if (t.empty()) return Value(LLUUID());
+            auto uuid = LLUUID::parse(t);
+            if (!uuid) fail("invalid <uuid>");
+            return Value(*uuid);
+        }
+        if (name == "date") {
+            auto t = trim_xml_space(text);
+            LLDate date;
+            if (!t.empty() && !parse_date_string(t, date)) fail("invalid <date>");
+            return Value(date);
+        }
+        if (name == "uri") return Value(URI{std::string(text)});
+        if (name == "binary") {
+            if (tag.encoding.empty() || tag.encoding == "base64") return Value(Binary{from_base64(text)});
+            if (tag.encoding == "base16") return Value(Binary{from_base16(text)});
+            fail("unsupported <binary> encoding");
+        }
+        fail("unknown element");
+    }
+
+    const char* p_;
+    const char* end_;
+    std::string scratch_;
+};
+
+} // namespace detail
+
+// Parses an LLSD XML document (python-llsd's format_xml output and the
+// classic viewer dialect) into the same Value types parse_binary produces.
+inline Value parse_xml(std::string_view s) {
+    return detail::XmlParser(s).parse_document();
+}
+
+// Forward declaration for the XML formatter
+std::string format_xml(const Value& v);
+void format_xml(std::ostream& s, const Value& v);
+void format_xml(const ChunkSink& sink, const Value& v, std::size_t chunk_size = 64 * 1024);
+
+namespace detail {
+
+// Helper to find the first byte in [p, end) that XML output cannot copy
+// verbatim: markup characters, C0 controls, and 0xEF (which leads the
+// U+FFFE/U+FFFF noncharacters python-llsd strips)
+inline const char* find_xml_escape(const char* p, const char* end) {
+#if LLSD_MODERN_HAS_SSE2
+    const __m128i amp = _mm_set1_epi8('&');
+    const __m128i lt = _mm_set1_epi8('<');
+    const __m128i gt = _mm_set1_epi8('>');
+    const __m128i ef = _mm_set1_epi8(static_cast<char>(0xEF));
+    const __m128i ctl = _mm_set1_epi8(0x1F);
+    for (; end - p >= 16; p += 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i hits = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, amp), _mm_cmpeq_epi8(chunk, lt)),
+                                    _mm_or_si128(_mm_cmpeq_epi8(chunk, gt), _mm_cmpeq_epi8(chunk, ef)));
+        hits = _mm_or_si128(hits, _mm_cmpeq_epi8(_mm_max_epu8(chunk, ctl), ctl));
+        int mask = _mm_movemask_epi8(hits);
+        if (mask) {
+#if defined(_MSC_VER) && !defined(__clang__)
+            unsigned long index;
+            _BitScanForward(&index, static_cast<unsigned long>(mask));
+            return p + index;
+#else
+            return p + __builtin_ctz(static_cast<unsigned>(mask));
+#endif
+        }
+    }
+#endif
+    for (; p != end; ++p) {
+        unsigned char c = static_cast<unsigned char>(*p);
+        if (c < 0x20 || c == '&' || c == '<' || c == '>' || c == 0xEF) return p;
+    }
+    return end;
+}
+
+// Helper to write XML character data the way python-llsd's xml_esc() does:
+// escape '&', '<' and '>', and drop bytes XML 1.0 cannot carry
+inline void write_xml_escaped(OutputBuffer& out, std::string_view str) {
+    const char* p = str.data();
+    const char* end = p + str.size();
+    for (;;) {
+        const char* run = p;
+        p = find_xml_escape(p, end);
+        out.append(run, p - run);
+        if (p == end) return;
+        unsigned char c = static_cast<unsigned char>(*p);
+        switch (c) {
+            case '&': out.append("&amp;", 5); break;
+            case '<': out.append("&lt;", 4); break;
+            case '>': out.append("&gt;", 4); break;
+            case '\t': case '\n': case '\r': out.put(static_cast<char>(c)); break;
+            case 0xEF:
+                // U+FFFE and U+FFFF are dropped; other 0xEF sequences pass
+                if (end - p >= 3 && static_cast<unsigned char>(p[1]) == 0xBF &&
+                    (static_cast<unsigned char>(p[2]) & 0xFE) == 0xBE) {
+                    p += 2;
+                } else {
+                    out.put(static_cast<char>(c));
+                }
+                break;
+            default:
+                // Remaining C0 controls are invalid in XML 1.0
+                break;
+        }
+        ++p;
+    }
+}
+
+// Element fragments per Value alternative, indexed by variant index: the
+// opening tag, the closing tag, and the empty-element form python-llsd
+// emits when an element has no content
+struct XmlTag {
+    std::string_view open;
+    std::string_view close;
+    std::string_view empty;
+};
+
+inline constexpr XmlTag kXmlTags[] = {
+    {"<undef>", "</undef>", "<undef />"},
+    {"<boolean>", "</boolean>", "<boolean />"},
+    {"<integer>", "</integer>", "<integer />"},
+    {"<real>", "</real>", "<real />"},
+    {"<string>", "</string>", "<string />"},
+    {"<uuid>", "</uuid>", "<uuid />"},
+    {"<date>", "</date>", "<date />"},
+    {"<uri>", "</uri>", "<uri />"},
+    {"<binary>", "</binary>", "<binary />"},
+    {"<array>", "</array>", "<array />"},
+    {"<map>", "</map>", "<map />"},
+};
+static_assert(std::size(kXmlTags) == std::variant_size_v<Value::variant_type>,
+              "kXmlTags must cover every Value alternative");
+
+inline void _format_xml_recurse(OutputBuffer& out, const Value& v) {
+    const XmlTag& tag = kXmlTags[v.data.index()];
+    std::visit([&](auto&& arg) {
+        using T = std::decay_t<decltype(arg)>;
+        if constexpr (std::is_same_v<T, Undef>) {
+            out.append(tag.empty);
+        } else if constexpr (std::is_same_v<T, bool>) {
+            out.append(arg ? std::string_view("<boolean>true</boolean>") : std::string_view("<boolean>false</boolean>"));
+        } else if constexpr (std::is_same_v<T, std::int32_t>) {
+            char buf[kNumberBufferSize];
+            out.append(tag.open);
+            out.append(buf, format_integer(buf, arg) - buf);
+            out.append(tag.close);
+        } else if constexpr (std::is_same_v<T, double>) {
+            char buf[kNumberBufferSize];
+            out.append(tag.open);
+            out.append(buf, format_real(buf, arg, kPythonRealMaxExp) - buf);
+            out.append(tag.close);
+        } else if constexpr (std::is_same_v<T, std::string> || std::is_same_v<T, URI>) {
+            const std::string& str = [&]() -> const std::string& {
+                if constexpr (std::is_same_v<T, URI>) return arg.s; else return arg;
+            }();
+            if (str.empty()) {
+                out.append(tag.empty);
+            } else {
+                out.append(tag.open);
+                write_xml_escaped(out, str);
+                out.append(tag.close);
+            }
+        } else if constexpr (std::is_same_v<T, LLUUID>) {
+            if (arg.isNull()) {
+                out.append(tag.empty);
+            } else {
+                char buf[LLUUID::kStringSize];
+                arg.toChars(buf);
+                out.append(tag.open);
+                out.append(buf, sizeof buf);
+                out.append(tag.close);
+            }
+        } else if constexpr (std::is_same_v<T, LLDate>) {
+            out.append(tag.open);
+            out.append(arg.toString());
+            out.append(tag.close);
+        } else if constexpr (std::is_same_v<T, Binary>) {
+            if (arg.b.empty()) {
+                out.append(tag.empty);
+            } else {
+                out.append(tag.open);
+                append_base64(out, arg.b.data(), arg.b.size());
+                out.append(tag.close);
+            }
+        } else if constexpr (std::is_same_v<T, std::unique_ptr<Array>>) {
+            if (!arg || arg->empty()) {
+                out.append(tag.empty);
+            } else {
+                out.append(tag.open);
+                for (const auto& item : *arg) {
+                    _format_xml_recurse(out, item);
+                }
+                out.append(tag.close);
+            }
+        } else if constexpr (std::is_same_v<T, std::unique_ptr<Map>>) {
+            if (!arg || arg->empty()) {
+                out.append(tag.empty);
+            } else {
+                out.append(tag.open);
+                for (const auto& [key, value] : *arg) {
+                    if (key.empty()) {
+                        out.append("<key />", 7);
+                    } else {
+                        out.append("<key>", 5);
+                        write_xml_escaped(out, key);
+                        out.append("</key>", 6);
+                    }
+                    _format_xml_recurse(out, value);
+                }
+                out.append(tag.close);
+            }
+        }
+    }, v.data);
+}
+
+inline void _format_xml_document(OutputBuffer& out, const Value& v) {
+    out.append("<?xml version=\"1.0\" ?><llsd>", 28);
+    _format_xml_recurse(out, v);
+    out.append("</llsd>", 7);
+}
+
+} // namespace detail
+
+// Formats `v` as LLSD XML, byte-for-byte as python-llsd's format_xml does
+inline std::string format_xml(const Value& v) {
+    detail::OutputBuffer out;
+    detail::_format_xml_document(out, v);
+    return std::move(out.str());
+}
+
+inline void format_xml(std::ostream& s, const Value& v) {
+    ChunkSink sink = [&s](std::string_view chunk) { s.write(chunk.data(), chunk.size()); };
+    format_xml(sink, v);
+}
+
+inline void format_xml(const ChunkSink& sink, const Value& v, std::size_t chunk_size) {
+    detail::OutputBuffer out(sink, chunk_size);
+    detail::_format_xml_document(out, v);
+    out.flush();
+}
+
+// Forward declaration for the notation parser
+Value parse_notation(std::string_view s);
+
+namespace detail {
+
+// Helper to decode a base85 string (RFC 1924 alphabet, as Python's
+// base64.b85decode), ignoring whitespace
+inline std::vector<std::uint8_t> from_base85(std::string_view s) {
+    static const auto T = [] {
+        static const char* alphabet =
+            "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz!#$%&()*+-;<=>?@^_`{|}~";
+        std::array<int, 256> table;
+        table.fill(-1);
+        for (int i = 0; i < 85; ++i) table[static_cast<unsigned char>(alphabet[i])] = i;
+        return table;
+    }();
+    std::vector<std::uint8_t> out;
+    out.reserve(s.size() / 5 * 4 + 4);
+    std::uint64_t acc = 0;
+    int n = 0;
+    auto emit = [&](int bytes) {
+        if (acc > 0xFFFFFFFFull) throw std::runtime_error("Invalid base85 data");
+        for (int i = 0; i < bytes; ++i) out.push_back(static_cast<std::uint8_t>(acc >> (24 - 8 * i)));
+    };
+    for (char c : s) {
+        if (c == ' ' || c == '\t' || c == '\n' || c == '\r') continue;
+        int d = T[static_cast<unsigned char>(c)];
+        if (d < 0) throw std::runtime_error("Invalid base85 data");
+        acc = acc * 85 + d;
+        if (++n == 5) {
+            emit(4);
+            acc = 0;
+            n = 0;
+        }
+    }
+    if (n) {
+        if (n == 1) throw std::runtime_error("Invalid base85 data");
+        // Pad the final group with the highest digit, keeping n - 1 bytes
+        for (int i = n; i < 5; ++i) acc = acc * 85 + 84;
+        emit(n - 1);
+    }
+    return out;
+}
+
+// Character classes driving the notation scanner
+enum NotationToken : std::uint8_t {
+    kNotationInvalid, kNotationSpace, kNotationUndef, kNotationTrue, kNotationFalse,
+    kNotationInteger, kNotationReal, kNotationUUID, kNotationString, kNotationSizedString,
+    kNotationURI, kNotationDate, kNotationBinary, kNotationMap, kNotationArray
+};
+
+inline constexpr auto kNotationTokens = [] {
+    std::array<std::uint8_t, 256> table{};
+    table[' '] = table['\t'] = table['\n'] = table['\r'] = kNotationSpace;
+    table['!'] = kNotationUndef;
+    table['1'] = table['t'] = table['T'] = kNotationTrue;
+    table['0'] = table['f'] = table['F'] = kNotationFalse;
+    table['i'] = kNotationInteger;
+    table['r'] = kNotationReal;
+    table['u'] = kNotationUUID;
+    table['\''] = table['"'] = kNotationString;
+    table['s'] = kNotationSizedString;
+    table['l'] = kNotationURI;
+    table['d'] = kNotationDate;
+    table['b'] = kNotationBinary;
+    table['{'] = kNotationMap;
+    table['['] = kNotationArray;
+    return table;
+}();
+
+// Single-pass scanner for LLSD notation, dispatching on the first byte of
+// each value through kNotationTokens. Quoted strings without escapes are
+// taken as views into the input.
+class NotationParser {
+public:
+    explicit NotationParser(std::string_view text)
+        : begin_(text.data()), p_(text.data()), end_(text.data() + text.size()) {}
+
+    Value parse_document() {
+        Value v = parse_value();
+        skip_space();
+        if (p_ != end_) fail("unexpected trailing data");
+        return v;
+    }
+
+private:
+    [[noreturn]] void fail(const char* what) const {
+        throw std::runtime_error(std::string("Invalid LLSD notation: ") + what + " at offset " +
+                                 std::to_string(p_ - begin_));
+    }
+
+    void skip_space() {
+        while (p_ != end_ && kNotationTokens[static_cast<unsigned char>(*p_)] == kNotationSpace) ++p_;
+    }
+
+    char next() {
+        if (p_ == end_) fail("unexpected end of input");
+        return *p_++;
+    }
+
+    void expect(char c) {
+        if (next() != c) {
+            --p_;
+            fail("unexpected character");
+        }
+    }
+
+    // Consumes `word` if the input continues with it
+    bool accept(std::string_view word) {
+        if (static_cast<std::size_t>(end_ - p_) >= word.size() && std::memcmp(p_, word.data(), word.size()) == 0) {
+            p_ += word.size();
+            return true;
+        }
+        return false;
+    }
+
+    // Reads a quoted string whose opening delimiter has been consumed
+    std::string_view read_delimited(char delim, std::string& scratch) {
+        const char* start = p_;
+        const char* close = static_cast<const char*>(std::memchr(p_, delim, end_ - p_));
+        if (!close) fail("unterminated string");
+        if (!std::memchr(start, '\\', close - start)) {
+            p_ = close + 1;
+            return std::string_view(start, close - start);
+        }
+        scratch.clear();
+        for (;;) {
+            char c = next();
+            if (c == delim) return scratch;
+            if (c != '\\') {
+                scratch += c;
+                continue;
+            }
+            c = next();
+            switch (c) {
+                case 'a': scratch += '\a'; break;
+                case 'b': scratch += '\b'; break;
+                case 'f': scratch += '\f'; break;
+                case 'n': scratch += '\n'; break;
+                case 'r': scratch += '\r'; break;
+                case 't': scratch += '\t'; break;
+                case 'v': scratch += '\v'; break;
+                case 'x': {
+                    std::uint8_t byte = 0;
+                    const char hex[2] = {next(), next()};
+                    auto res = std::from_chars(hex, hex + 2, byte, 16);
+                    if (res.ec != std::errc() || res.ptr != hex + 2) fail("invalid \\x escape");
+                    scratch += static_cast<char>(byte);
+                    break;
+                }
+                default: scratch += c;
+            }
+        }
+    }
+
+    // Reads "(N)" followed by a delimiter, N raw bytes and the delimiter
+    std::string_view read_sized() {
+        expect('(');
+        const char* digits = p_;
+        while (p_ != end_ && *p_ >= '0' && *p_ <= '9') ++p_;
+        std::int32_t size = 0;
+        if (!parse_integer(std::string_view(digits, p_ - digits), size) || size < 0) fail("invalid size");
+        expect(')');
+        char delim = next();
+        if (delim != '"' && delim != '\'') fail("expected quote after size");
+        // Compared in ptrdiff_t: size + 1 would overflow for the largest size
+        if (static_cast<std::ptrdiff_t>(size) >= end_ - p_) fail("sized data runs past end of input");
+        std::string_view data(p_, size);
+        p_ += size;
+        expect(delim);
+        return data;
+    }
+
+    std::string_view read_quoted(std::string& scratch) {
+        char delim = next();
+        if (delim != '"' && delim != '\'') fail("expected quote");
+        return read_delimited(delim, scratch);
+    }
+
+    // Reads the run of characters that can make up a number
+    std::string_view read_number_chars(bool real) {
+        const char* start = p_;
+        while (p_ != end_) {
+            char c = *p_;
+            if ((c >= '0' && c <= '9') || c == '-' || c == '+' ||
+                (real && c != '\0' && std::string_view(".eEnNaAiIfFtTyY").find(c) != std::string_view::npos)) {
+                ++p_;
+            } else {
+                break;
+            }
+        }
+        return std::string_view(start, p_ - start);
+    }
+
+    std::string_view read_key() {
+        skip_space();
+        if (p_ != end_ && *p_ == 's') {
+            ++p_;
+            return read_sized();
+        }
+        return read_quoted(scratch_);
+    }
+
+    Value parse_value() {
+        skip_space();
+        if (p_ == end_) fail("unexpected end of input");
+        const char c = *p_++;
+        switch (kNotationTokens[static_cast<unsigned char>(c)]) {
+            case kNotationUndef: return Value(Undef{});
+            case kNotationTrue:
+                if (c == 't') accept("rue");
+                else if (c == 'T') accept("RUE");
+                return Value(true);
+            case kNotationFalse:
+                if (c == 'f') accept("alse");
+                else if (c == 'F') accept("ALSE");
+                return Value(false);
+            case kNotationInteger: {
+                std::int32_t i = 0;
+                if (!parse_integer(read_number_chars(false), i)) fail("invalid integer");
+                return Value(i);
+            }
+            case kNotationReal: {
+                double r = 0.0;
+                if (!parse_real(read_number_chars(true), r)) fail("invalid real");
+                return Value(r);
+            }
+            case kNotationUUID: {
+                if (end_ - p_ < 36) fail("truncated uuid");
+                auto uuid = LLUUID::parse(std::string_view(p_, 36));
+                if (!uuid) fail("invalid uuid");
+                p_ += 36;
+                return Value(*uuid);
+            }
+            case kNotationString:
+                return Value(std::string(read_delimited(c, scratch_)));
+            case kNotationSizedString:
+                return Value(std::string(read_sized()));
+            case kNotationURI:
+                return Value(URI{std::string(read_quoted(scratch_))});
+            case kNotationDate: {
+                auto text = read_quoted(scratch_);
+                LLDate date;
+                if (!text.empty() && !parse_date_string(text, date)) fail("invalid date");
+                return Value(date);
+            }
+            case kNotationBinary: {
+                if (p_ != end_ && *p_ == '(') {
+                    auto raw = read_sized();
+                    return Value(Binary{std::vector<std::uint8_t>(raw.begin(), raw.end())});
+                }
+                if (accept("64")) return Value(Binary{from_base64(read_quoted(scratch_))});
+                if (accept("16")) return Value(Binary{from_base16(read_quoted(scratch_))});
+                if (accept("85")) return Value(Binary{from_base85(read_quoted(scratch_))});
+                fail("unknown binary encoding");
+            }
+            case kNotationMap: {
+                auto map = std::make_unique<Map>();
+                for (;;) {
+                    skip_space();
+                    if (p_ != end_ && *p_ == '}') break;
+                    if (!map->empty()) {
+                        expect(',');
+                        skip_space();
+                    }
+                    std::string key(read_key());
+                    skip_space();
+                    expect(':');
+                    (*map)[std::move(key)] = parse_value();
+                }
+                ++p_;
+                return Value(std::move(map));
+            }
+            case kNotationArray: {
+                auto array = std::make_unique<Array>();
+                for (;;) {
+                    skip_space();
+                    if (p_ != end_ && *p_ == ']') break;
+                    if (!array->empty()) expect(',');
+                    array->push_back(parse_value());
+                }
+                ++p_;
+                return Value(std::move(array));
+            }
+            default:
+                --p_;
+                fail("unexpected character");
+        }
+    }
+
+    const char* begin_;
+    const char* p_;
+    const char* end_;
+    std::string scratch_;
+};
+
+} // namespace detail
+
+// Parses an LLSD notation document, as written by python-llsd's
+// format_notation and the viewer's notation formatter
+inline Value parse_notation(std::string_view s) {
+    return detail::NotationParser(s).parse_document();
+}
+
+// Forward declaration for the notation formatter
+std::string format_notation(const Value& v);
+void format_notation(std::ostream& s, const Value& v);
+void format_notation(const ChunkSink& sink, const Value& v, std::size_t chunk_size = 64 * 1024);
+
+namespace detail {
+
+// Helper to write `str` with backslash escapes for '\\' and `quote`
+inline void write_notation_escaped(OutputBuffer& out, std::string_view str, char quote) {
+    const char* p = str.data();
+    const char* end = p + str.size();
+    const char* run = p;
+    for (; p != end; ++p) {
+        if (*p != '\\' && *p != quote) continue;
+        out.append(run, p - run);
+        out.put('\\');
+        run = p;
+    }
+    out.append(run, p - run);
+}
+
+// Helper to write a string in the cheapest legal notation form: python-llsd's
+// single-quoted form, a double-quoted form when that needs fewer escapes, or
+// a sized s(N)"..." form when escaping would cost more than the size prefix
+inline void write_notation_string(OutputBuffer& out, std::string_view str) {
+    std::size_t backslashes = 0, singles = 0, doubles = 0;
+    for (char c : str) {
+        backslashes += c == '\\';
+        singles += c == '\'';
+        doubles += c == '"';
+    }
+    char size_buf[kNumberBufferSize];
+    const std::size_t size_len = std::to_chars(size_buf, size_buf + sizeof(size_buf), str.size()).ptr - size_buf;
+    const std::size_t single_cost = backslashes + singles;
+    const std::size_t double_cost = backslashes + doubles;
+    const std::size_t sized_cost = size_len + 3;
+    if (single_cost <= double_cost && single_cost <= sized_cost) {
+        out.put('\'');
+        if (single_cost) write_notation_escaped(out, str, '\''); else out.append(str);
+        out.put('\'');
+    } else if (double_cost <= sized_cost) {
+        out.put('"');
+        write_notation_escaped(out, str, '"');
+        out.put('"');
+    } else {
+        out.append("s(", 2);
+        out.append(size_buf, size_len);
+        out.append(")\"", 2);
+        out.append(str);
+        out.put('"');
+    }
+}
+
+inline void _format_notation_recurse(OutputBuffer& out, const Value& v) {
+    std::visit([&](auto&& arg) {
+        using T = std::decay_t<decltype(arg)>;
+        if constexpr (std::is_same_v<T, Undef>) {
+            out.put('!');
+        } else if constexpr (std::is_same_v<T, bool>) {
+            out.append(arg ? std::string_view("true") : std::string_view("false"));
+        } else if constexpr (std::is_same_v<T, std::int32_t>) {
+            char buf[kNumberBufferSize + 1];
+            buf[0] = 'i';
+            out.append(buf, format_integer(buf + 1, arg) - buf);
+        } else if constexpr (std::is_same_v<T, double>) {
+            char buf[kNumberBufferSize + 1];
+            buf[0] = 'r';
+            out.append(buf, format_real(buf + 1, arg, kPythonRealMaxExp) - buf);
+        } else if constexpr (std::is_same_v<T, std::string>) {
+            write_notation_string(out, arg);
+        } else if constexpr (std::is_same_v<T, LLUUID>) {
+            char buf[1 + LLUUID::kStringSize];
+            buf[0] = 'u';
+            arg.toChars(buf + 1);
+            out.append(buf, sizeof buf);
+        } else if constexpr (std::is_same_v<T, LLDate>) {
+            out.append("d\"", 2);
+            out.append(arg.toString());
+            out.put('"');
+        } else if constexpr (std::is_same_v<T, URI>) {
+            out.append("l\"", 2);
+            write_notation_escaped(out, arg.s, '"');
+            out.put('"');
+        } else if constexpr (std::is_same_v<T, Binary>) {
+            out.append("b64\"", 4);
+            append_base64(out, arg.b.data(), arg.b.size());
+            out.put('"');
+        } else if constexpr (std::is_same_v<T, std::unique_ptr<Array>>) {
+            out.put('[');
+            if (arg) {
+                bool first = true;
+                for (const auto& item : *arg) {
+                    if (!first) out.put(',');
+                    first = false;
+                    _format_notation_recurse(out, item);
+                }
+            }
+            out.put(']');
+        } else if constexpr (std::is_same_v<T, std::unique_ptr<Map>>) {
+            out.put('{');
+            if (arg) {
+                bool first = true;
+                for (const auto& [key, value] : *arg) {
+                    if (!first) out.put(',');
+                    first = false;
+                    write_notation_string(out, key);
+                    out.put(':');
+                    _format_notation_recurse(out, value);
+                }
+            }
+            out.put('}');
+        }
+    }, v.data);
+}
+
+} // namespace detail
+
+// Formats `v` as LLSD notation in the shape of python-llsd's
+// format_notation, with strings in their cheapest legal quoting
+inline std::string format_notation(const Value& v) {
+    detail::OutputBuffer out;
+    detail::_format_notation_recurse(out, v);
+    return std::move(out.str());
+}
+
+inline void format_notation(std::ostream& s, const Value& v) {
+    ChunkSink sink = [&s](std::string_view chunk) { s.write(chunk.data(), chunk.size()); };
+    format_notation(sink, v);
+}
+
+inline void format_notation(const ChunkSink& sink, const Value& v, std::size_t chunk_size) {
+    detail::OutputBuffer out(sink, chunk_size);
+    detail::_format_notation_recurse(out, v);
+    out.flush();
+}
+
+// Header that marks (and is required by) the compact binary encoding
+inline constexpr std::string_view kCompactHeader = "<?llsd/compact?>\n";
+
+// Forward declaration for the compact formatter
+std::string format_compact(const Value& v);
+void format_compact(std::ostream& s, const Value& v);
+void format_compact(const ChunkSink& sink, const Value& v, std::size_t chunk_size = 64 * 1024);
+
+namespace detail {
+
+// Compact binary LLSD: the classic binary tokens, but with LEB128 varint
+// lengths and counts, zigzag varint integers, little-endian reals and dates,
+// no container terminators, and map keys written once per document. Each key
+// is a varint `n`: an even `n` is followed by `n / 2` bytes of a new key, which
+// is appended to the document's dictionary; an odd `n` refers to dictionary
+// entry `n / 2`.
+class CompactWriter {
+public:
+    explicit CompactWriter(OutputBuffer& out) : out_(out) {}
+
+    void write(const Value& v) {
+        std::visit([&](auto&& arg) {
+            using T = std::decay_t<decltype(arg)>;
+            if constexpr (std::is_same_v<T, Undef>) {
+                out_.put('!');
+            } else if constexpr (std::is_same_v<T, bool>) {
+                out_.put(arg ? '1' : '0');
+            } else if constexpr (std::is_same_v<T, std::int32_t>) {
+                out_.put('i');
+                auto u = static_cast<std::uint32_t>(arg);
+                write_varint((u << 1) ^ (arg < 0 ? 0xFFFFFFFFu : 0u));
+            } else if constexpr (std::is_same_v<T, double>) {
+                out_.put('r');
+                write_double(arg);
+            } else if constexpr (std::is_same_v<T, std::string>) {
+                out_.put('s');
+                write_sized(arg.data(), arg.size());
+            } else if constexpr (std::is_same_v<T, LLUUID>) {
+                out_.put('u');
+                out_.append(reinterpret_cast<const char*>(arg.bytes().data()), 16);
+            } else if constexpr (std::is_same_v<T, LLDate>) {
+                out_.put('d');
+                write_double(std::chrono::duration<double>(arg.timePoint().time_since_epoch()).count());
+            } else if constexpr (std::is_same_v<T, URI>) {
+                out_.put('l');
+                write_sized(arg.s.data(), arg.s.size());
+            } else if constexpr (std::is_same_v<T, Binary>) {
+                out_.put('b');
+                write_sized(reinterpret_cast<const char*>(arg.b.data()), arg.b.size());
+            } else if constexpr (std::is_same_v<T, std::unique_ptr<Array>>) {
+                out_.put('[');
+                write_varint(arg ? checked_size(arg->size()) : 0);
+                if (arg) {
+                    for (const auto& item : *arg) write(item);
+                }
+            } else if constexpr (std::is_same_v<T, std::unique_ptr<Map>>) {
+                out_.put('{');
+                write_varint(arg ? checked_size(arg->size()) : 0);
+                if (arg) {
+                    for (const auto& [key, value] : *arg) {
+                        write_key(key);
+                        write(value);
+                    }
+                }
+            }
+        }, v.data);
+    }
+
+private:
+    static std::uint32_t checked_size(std::size_t n) {
+        if (n > 0x7FFFFFFF) throw std::runtime_error("Value too large for compact LLSD");
+        return static_cast<std::uint32_t>(n);
+    }
+
+    void write_varint(std::uint32_t u) {
+        char buf[5];
+        std::size_t n = 0;
+        while (u >= 0x80) {
+            buf[n++] = static_cast<char>(u | 0x80);
+            u >>= 7;
+        }
+        buf[n++] = static_cast<char>(u);
+        out_.append(buf, n);
+    }
+
+    void write_double(double d) {
+        std::uint64_t bits;
+        std::memcpy(&bits, &d, sizeof bits);
+        char buf[8];
+        for (int i = 0; i < 8; ++i) buf[i] = static_cast<char>(bits >> (8 * i));
+        out_.append(buf, 8);
+    }
+
+    void write_sized(const char* data, std::size_t size) {
+        write_varint(checked_size(size));
+        out_.append(data, size);
+    }
+
+    void write_key(const std::string& key) {
+        auto [it, inserted] = keys_.try_emplace(key, static_cast<std::uint32_t>(keys_.size()));
+        if (!inserted) {
+            write_varint(it->second << 1 | 1);
+            return;
+        }
+        write_varint(checked_size(key.size()) << 1);
+        out_.append(key);
+    }
+
+    OutputBuffer& out_;
+    // Keys of the document being written, which outlives the writer
+    std::unordered_map<std::string_view, std::uint32_t> keys_;
+};
+
+class CompactParser {
+public:
+    explicit CompactParser(std::string_view data)
+        : begin_(data.data()), p_(data.data()), end_(data.data() + data.size()) {}
+
+    Value parse_document() {
+        Value v = parse_value();
+        if (p_ != end_) fail("unexpected trailing data");
+        return v;
+    }
+
+private:
+    [[noreturn]] void fail(const char* what) const {
+        throw std::runtime_error(std::string("Invalid compact LLSD: ") + what + " at offset " +
+                                 std::to_string(p_ - begin_));
+    }
+
+    void need(std::size_t n) {
+        if (static_cast<std::size_t>(end_ - p_) < n) fail("unexpected end of input");
+    }
+
+    std::uint32_t read_varint() {
+        std::uint32_t u = 0;
+        for (int shift = 0; shift < 35; shift += 7) {
+            need(1);
+            auto b = static_cast<std::uint8_t>(*p_++);
+            if (shift == 28 && b > 0x0F) fail("varint overflow");
+            u |= static_cast<std::uint32_t>(b & 0x7F) << shift;
+            if (!(b & 0x80)) return u;
+        }
+        fail("varint overflow");
+    }
+
+    double read_double() {
+        need(8);
+        std::uint64_t bits = 0;
+        for (int i = 0; i < 8; ++i) bits |= static_cast<std::uint64_t>(static_cast<std::uint8_t>(p_[i])) << (8 * i);
+        p_ += 8;
+        double d;
+        std::memcpy(&d, &bits, sizeof d);
+        return d;
+    }
+
+    std::string_view read_sized(std::uint32_t size) {
+        need(size);
+        std::string_view s(p_, size);
+        p_ += size;
+        return s;
+    }
+
+    std::string_view read_key() {
+        std::uint32_t n = read_varint();
+        if (n & 1) {
+            if ((n >> 1) >= keys_.size()) fail("unknown key index");
+            return keys_[n >> 1];
+        }
+        keys_.push_back(read_sized(n >> 1));
+        return keys_.back();
+    }
+
+    // Caps a declared element count by the bytes left, since every element
+    // takes at least one
+    std::size_t plausible_count(std::uint32_t count) const {
+        return std::min<std::size_t>(count, static_cast<std::size_t>(end_ - p_));
+    }
+
+    Value parse_value() {
+        need(1);
+        char token = *p_++;
+        switch (token) {
+            case '!': return Value(Undef{});
+            case '0': return Value(false);
+            case '1': return Value(true);
+            case 'i': {
+                std::uint32_t u = read_varint();
+                return Value(static_cast<std::int32_t>((u >> 1) ^ (0u - (u & 1))));
+            }
+            case 'r': return Value(read_double());
+            case 's': return Value(std::string(read_sized(read_varint())));
+            case 'l': return Value(URI{std::string(read_sized(read_varint()))});
+            case 'u': {
+                std::string_view raw = read_sized(16);
+                std::array<std::uint8_t, 16> bytes;
+                std::memcpy(bytes.data(), raw.data(), 16);
+                return Value(LLUUID(bytes));
+            }
+            case 'd': {
+                auto duration = std::chrono::duration<double>(read_double());
+                return Value(LLDate(std::chrono::system_clock::time_point(
+                    std::chrono::round<std::chrono::system_clock::duration>(duration))));
+            }
+            case 'b': {
+                std::string_view raw = read_sized(read_varint());
+                return Value(Binary{std::vector<std::uint8_t>(raw.begin(), raw.end())});
+            }
+            case '[': {
+                std::uint32_t count = read_varint();
+                auto array = std::make_unique<Array>();
+                array->reserve(plausible_count(count));
+                for (std::uint32_t i = 0; i < count; ++i) array->push_back(parse_value());
+                return Value(std::move(array));
+            }
+            case '{': {
+                std::uint32_t count = read_varint();
+                auto map = std::make_unique<Map>();
+                map->reserve(count);
+                for (std::uint32_t i = 0; i < count; ++i) {
+                    std::string_view key = read_key();
+                    (*map)[std::string(key)] = parse_value();
+                }
+                return Value(std::move(map));
+            }
+            default:
+                --p_;
+                fail("invalid token");
+        }
+    }
+
+    const char* begin_;
+    const char* p_;
+    const char* end_;
+    // Keys seen so far, pointing into the input
+    std::vector<std::string_view> keys_;
+};
+
+} // namespace detail
+
+// Parses compact binary LLSD, which must start with kCompactHeader
+inline Value parse_compact(std::string_view buffer) {
+    if (buffer.substr(0, kCompactHeader.size()) != kCompactHeader) {
+        throw std::runtime_error("Invalid compact LLSD: missing header");
+    }
+    return detail::CompactParser(buffer.substr(kCompactHeader.size())).parse_document();
+}
+
+// Formats `v` as compact binary LLSD, header included. This encoding is only
+// understood by this library; use format_binary() for interop.
+inline std::string format_compact(const Value& v) {
+    detail::OutputBuffer out;
+    out.append(kCompactHeader);
+    detail::CompactWriter(out).write(v);
+    return std::move(out.str());
+}
+
+inline void format_compact(std::ostream& s, const Value& v) {
+    ChunkSink sink = [&s](std::string_view chunk) { s.write(chunk.data(), chunk.size()); };
+    format_compact(sink, v);
+}
+
+inline void format_compact(const ChunkSink& sink, const Value& v, std::size_t chunk_size) {
+    detail::OutputBuffer out(sink, chunk_size);
+    out.append(kCompactHeader);
+    detail::CompactWriter(out).write(v);
+    out.flush();
+}
+
+// Serialization formats understood by parse() and format()
+enum class Format { Binary, Notation, XML, JSON, Compact };
+
+// Headers python-llsd writes ahead of (and accepts before) the binary and
+// notation encodings
+inline constexpr std::string_view kBinaryHeader = "<?llsd/binary?>\n";
+inline constexpr std::string_view kNotationHeader = "<? llsd/notation ?>\n";
+
+namespace detail {
+
+inline bool is_json_space(char c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r'; }
+
+// Helper to strip an "<?llsd/NAME?>" or "<? llsd/NAME ?>" header line from
+// the front of `buf`, returning whether one was present
+inline bool strip_llsd_header(std::string_view& buf, std::string_view name) {
+    std::string_view rest = buf.substr(2);
+    if (!rest.empty() && rest[0] == ' ') rest.remove_prefix(1);
+    if (rest.substr(0, 5) != "llsd/" || rest.substr(5, name.size()) != name) return false;
+    auto close = rest.find("?>");
+    if (close == std::string_view::npos) return false;
+    rest.remove_prefix(close + 2);
+    if (!rest.empty() && rest[0] == '\r') rest.remove_prefix(1);
+    if (!rest.empty() && rest[0] == '\n') rest.remove_prefix(1);
+    buf = rest;
+    return true;
+}
+
+// Most bytes sniff_text_format() looks at past any leading whitespace
+inline constexpr std::size_t kSniffLookahead = 256;
+
+inline constexpr std::string_view kUtf8Bom = "\xEF\xBB\xBF";
+
+// Decides between JSON and notation from the first scalar of a document
+// whose leading byte is ambiguous, looking at no more than a fixed-size
+// prefix. Documents that read the same either way are treated as JSON.
+inline Format sniff_text_format(std::string_view buf) {
+    const char* p = buf.data();
+    const char* end = p + std::min(buf.size(), kSniffLookahead);
+    while (p != end) {
+        char c = *p;
+        if (is_json_space(c) || c == '[' || c == ',') {
+            ++p;
+        } else if (c == '{') {
+            // Skip a leading "key": so the value decides
+            ++p;
+            while (p != end && is_json_space(*p)) ++p;
+            if (p == end) break;
+            if (*p != '"') return *p == '}' ? Format::JSON : Format::Notation;
+            const char* close = p + 1;
+            while (close != end && *close != '"') close += *close == '\\' ? 2 : 1;
+            if (close >= end) break;
+            p = close + 1;
+            while (p != end && is_json_space(*p)) ++p;
+            if (p != end && *p == ':') ++p;
+        } else if (c == '"' || c == '-' || (c >= '2' && c <= '9') || c == 'n') {
+            return Format::JSON;
+        } else if (c == 't' || c == 'f') {
+            std::string_view word(p, end - p);
+            return (word.substr(0, 4) == "true" || word.substr(0, 5) == "false") ? Format::JSON : Format::Notation;
+        } else if (c == '0' || c == '1') {
+            // A lone 0 or 1 is a boolean in notation; anything longer is a
+            // JSON number
+            ++p;
+            if (p != end && std::string_view("0123456789.eE").find(*p) != std::string_view::npos) return Format::JSON;
+        } else if (c == ']' || c == '}') {
+            // Valid in both encodings; keep looking for a tie-breaker
+            ++p;
+        } else {
+            return Format::Notation;
+        }
+    }
+    return Format::JSON;
+}
+
+// Helper to detect the format of `buf` and narrow it to the payload that
+// follows any header or UTF-8 byte order mark
+inline Format sniff_format(std::string_view& buf) {
+    if (buf.substr(0, kUtf8Bom.size()) == kUtf8Bom) buf.remove_prefix(kUtf8Bom.size());
+    std::size_t start = 0;
+    while (start < buf.size() && is_json_space(buf[start])) ++start;
+    std::string_view rest = buf.substr(start);
+    if (rest.substr(0, 2) == "<?") {
+        if (strip_llsd_header(rest, "binary")) {
+            buf = rest;
+            return Format::Binary;
+        }
+        if (strip_llsd_header(rest, "notation")) {
+            buf = rest;
+            return Format::Notation;
+        }
+        if (strip_llsd_header(rest, "compact")) {
+            buf = rest;
+            return Format::Compact;
+        }
+    }
+    if (!rest.empty() && rest[0] == '<') {
+        buf = rest;
+        return Format::XML;
+    }
+    // Headerless binary: a token followed by raw bytes. For containers and
+    // sized tokens that is a big-endian size, whose leading byte is never
+    // printable text in practice
+    if (buf.size() >= 2 && std::string_view("{[isludrb").find(buf[0]) != std::string_view::npos) {
+        unsigned char c = static_cast<unsigned char>(buf[1]);
+        if ((c < 0x20 && !is_json_space(static_cast<char>(c))) || c >= 0x80) return Format::Binary;
+    }
+    buf = rest;
+    if (rest.empty()) throw std::runtime_error("Cannot detect LLSD format of empty input");
+    return sniff_text_format(rest);
+}
+
+} // namespace detail
+
+// Detects the serialization format of `buffer` from its header or leading
+// bytes, without parsing it
+inline Format detect_format(std::string_view buffer) {
+    return detail::sniff_format(buffer);
+}
+
+// Parses `buffer` in whichever format it is in: binary or notation (with or
+// without python-llsd's header), XML, JSON or compact binary
+inline Value parse(std::string_view buffer) {
+    switch (detail::sniff_format(buffer)) {
+        case Format::Binary: {
+            detail::ViewStreambuf buf(buffer);
+            std::istream in(&buf);
+            return parse_binary(in);
+        }
+        case Format::Notation: return parse_notation(buffer);
+        case Format::XML: return parse_xml(buffer);
+        case Format::JSON: return parse_json(buffer);
+        case Format::Compact: return detail::CompactParser(buffer).parse_document();
+    }
+    throw std::runtime_error("Unknown LLSD format");
+}
+
+// Formats `v` in `f`, prefixed with the header python-llsd uses for binary
+// and notation (or kCompactHeader) so that parse() can identify it
+inline void format(std::ostream& s, const Value& v, Format f) {
+    switch (f) {
+        case Format::Binary:
+            s.write(kBinaryHeader.data(), kBinaryHeader.size());
+            format_binary(s, v);
+            return;
+        case Format::Notation:
+            s.write(kNotationHeader.data(), kNotationHeader.size());
+            format_notation(s, v);
+            return;
+        case Format::XML: format_xml(s, v); return;
+        case Format::JSON: format_json(s, v); return;
+        case Format::Compact: format_compact(s, v); return;
+    }
+}
+
+// Appends `v` to `out` as format() writes it, using the capacity `out`
+// already has rather than a buffer of its own. If formatting throws, `out`
+// is left holding just what it held before.
+inline void format(std::string& out, const Value& v, Format f) {
+    const std::size_t original = out.size();
+    if (f == Format::Binary) {
+        try {
+            out.append(kBinaryHeader);
+            detail::StringSinkStreambuf sink(out);
+            std::ostream s(&sink);
+            s.exceptions(std::ios::badbit);
+            format_binary(s, v);
+        } catch (...) {
+            out.resize(original);
+            throw;
+        }
+        return;
+    }
+    detail::OutputBuffer buffer;
+    buffer.str() = std::move(out);
+    try {
+        switch (f) {
+            case Format::Notation:
+                buffer.append(kNotationHeader);
+                detail::_format_notation_recurse(buffer, v);
+                break;
+            case Format::XML: detail::_format_xml_document(buffer, v); break;
+            case Format::JSON: detail::_format_json_recurse(buffer, v); break;
+            case Format::Compact:
+                buffer.append(kCompactHeader);
+                detail::CompactWriter(buffer).write(v);
+                break;
+            default: throw std::runtime_error("Unknown LLSD format");
+        }
+    } catch (...) {
+        out = std::move(buffer.str());
+        out.resize(original);
+        throw;
+    }
+    out = std::move(buffer.str());
+}
+
+inline std::string format(const Value& v, Format f) {
+    std::string out;
+    format(out, v, f);
+    return out;
+}
+
+// Strings of one column packed into a single buffer
+class StringColumn {
+public:
+    std::size_t size() const { return offsets_.size() - 1; }
+
+    std::string_view operator[](std::size_t i) const {
+        return std::string_view(pool_.data() + offsets_[i], offsets_[i + 1] - offsets_[i]);
+    }
+
+    void reserve(std::size_t rows, std::size_t bytes) {
+        offsets_.reserve(rows + 1);
+        pool_.reserve(bytes);
+    }
+
+    void push_back(std::string_view s) {
+        if (pool_.size() + s.size() > std::numeric_limits<std::uint32_t>::max()) {
+            throw std::runtime_error("String column too large");
+        }
+        pool_.append(s);
+        offsets_.push_back(static_cast<std::uint32_t>(pool_.size()));
+    }
+
+private:
+    std::string pool_;
+    std::vector<std::uint32_t> offsets_{0};
+};
+
+// Column-oriented form of an array of maps that all have the same keys: one
+// key list plus one column per key. Columns whose values are all integers,
+// reals, UUIDs or strings are packed; any other column keeps its Values.
+class Columnar {
+public:
+    using Column = std::variant<
+        std::vector<std::int32_t>,
+        std::vector<double>,
+        std::vector<LLUUID>,
+        StringColumn,
+        std::vector<Value>
+    >;
+
+    // Converts `rows`, or returns nothing if they are not all maps with
+    // identical keys
+    static std::optional<Columnar> from_rows(const Array& rows) {
+        Columnar c;
+        c.rows_ = rows.size();
+        const Map* first = rows.empty() ? nullptr : row_map(rows[0]);
+        if (first) {
+            for (const auto& entry : *first) c.keys_.push_back(entry.first);
+        }
+        for (const auto& row : rows) {
+            const Map* map = row_map(row);
+            if (!map || map->size() != c.keys_.size()) return std::nullopt;
+            auto key = c.keys_.begin();
+            for (const auto& entry : *map) {
+                if (entry.first != *key++) return std::nullopt;
+            }
+        }
+
+        // Gather each column's cells in one pass over the rows
+        std::vector<std::vector<const Value*>> cells(c.keys_.size());
+        std::vector<bool> uniform(c.keys_.size(), true);
+        for (auto& column : cells) column.reserve(rows.size());
+        for (const auto& row : rows) {
+            std::size_t k = 0;
+            for (const auto& entry : *row_map(row)) {
+                if (!cells[k].empty() && entry.second.data.index() != cells[k].front()->data.index()) uniform[k] = false;
+                cells[k++].push_back(&entry.second);
+            }
+        }
+        c.columns_.reserve(c.keys_.size());
+        for (std::size_t k = 0; k < c.keys_.size(); ++k) {
+            c.columns_.push_back(make_column(cells[k], uniform[k]));
+        }
+        return c;
+    }
+
+    Array to_rows() const {
+        Array rows;
+        rows.reserve(rows_);
+        for (std::size_t i = 0; i < rows_; ++i) {
+            auto map = std::make_unique<Map>();
+            for (std::size_t k = 0; k < keys_.size(); ++k) {
+                map->emplace_hint(map->end(), keys_[k], get(i, k));
+            }
+            rows.push_back(Value(std::move(map)));
+        }
+        return rows;
+    }
+
+    std::size_t size() const { return rows_; }
+    const std::vector<std::string>& keys() const { return keys_; }
+
+    // The column for `key`; throws if there is none
+    const Column& column(std::string_view key) const { return columns_[key_index(key)]; }
+
+    // The value at `row` in the column for `key`
+    Value get(std::size_t row, std::string_view key) const { return get(row, key_index(key)); }
+
+    // Sum of an integer or real column, accumulated in independent lanes so
+    // the loop vectorizes
+    double sum(std::string_view key) const {
+        const Column& col = column(key);
+        if (auto ints = std::get_if<std::vector<std::int32_t>>(&col)) {
+            std::int64_t lanes[4] = {};
+            std::size_t i = 0, n = ints->size();
+            for (; i + 4 <= n; i += 4) {
+                for (int l = 0; l < 4; ++l) lanes[l] += (*ints)[i + l];
+            }
+            for (; i < n; ++i) lanes[0] += (*ints)[i];
+            return static_cast<double>(lanes[0] + lanes[1] + lanes[2] + lanes[3]);
+        }
+        if (auto reals = std::get_if<std::vector<double>>(&col)) {
+            double lanes[4] = {};
+            std::size_t i = 0, n = reals->size();
+            for (; i + 4 <= n; i += 4) {
+                for (int l = 0; l < 4; ++l) lanes[l] += (*reals)[i + l];
+            }
+            for (; i < n; ++i) lanes[0] += (*reals)[i];
+            return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+        }
+        throw std::runtime_error("Column is not numeric: " + std::string(key));
+    }
+
+    // Indices of the rows whose `key` satisfies `pred`. T is the packed
+    // element type (std::int32_t, double, LLUUID or std::string_view); throws
+    // if the column is not stored that way.
+    template <typename T, typename Pred>
+    std::vector<std::uint32_t> where(std::string_view key, Pred pred) const {
+        std::vector<std::uint32_t> out(rows_);
+        std::size_t n = 0;
+        scan<T>(key, [&](std::size_t i, bool match) {
+            // Branch-free compaction
+            out[n] = static_cast<std::uint32_t>(i);
+            n += match;
+        }, pred);
+        out.resize(n);
+        return out;
+    }
+
+    // Number of rows whose `key` satisfies `pred`, with T as for where()
+    template <typename T, typename Pred>
+    std::size_t count(std::string_view key, Pred pred) const {
+        std::size_t n = 0;
+        scan<T>(key, [&](std::size_t, bool match) { n += match; }, pred);
+        return n;
+    }
+
+private:
+    static const Map* row_map(const Value& v) {
+        auto map = std::get_if<std::unique_ptr<Map>>(&v.data);
+        return map ? map->get() : nullptr;
+    }
+
+    template <typename T>
+    static std::vector<T> gather(const std::vector<const Value*>& cells) {
+        std::vector<T> out;
+        out.reserve(cells.size());
+        for (const Value* v : cells) out.push_back(*std::get_if<T>(&v->data));
+        return out;
+    }
+
+    static Column make_column(const std::vector<const Value*>& cells, bool uniform) {
+        const auto& first = cells.front()->data;
+        if (uniform && std::holds_alternative<std::int32_t>(first)) return gather<std::int32_t>(cells);
+        if (uniform && std::holds_alternative<double>(first)) return gather<double>(cells);
+        if (uniform && std::holds_alternative<LLUUID>(first)) return gather<LLUUID>(cells);
+        if (uniform && std::holds_alternative<std::string>(first)) {
+            std::size_t bytes = 0;
+            for (const Value* v : cells) bytes += std::get_if<std::string>(&v->data)->size();
+            StringColumn strings;
+            strings.reserve(cells.size(), bytes);
+            for (const Value* v : cells) strings.push_back(*std::get_if<std::string>(&v->data));
+            return strings;
+        }
+        std::vector<Value> values;
+        values.reserve(cells.size());
+        for (const Value* v : cells) values.push_back(*v);
+        return values;
+    }
+
+    std::size_t key_index(std::string_view key) const {
+        auto it = std::lower_bound(keys_.begin(), keys_.end(), key,
+                                   [](const std::string& a, std::string_view b) { return a < b; });
+        if (it == keys_.end() || *it != key) throw std::runtime_error("No such column: " + std::string(key));
+        return static_cast<std::size_t>(it - keys_.begin());
+    }
+
+    Value get(std::size_t row, std::size_t k) const {
+        return std::visit([&](auto&& col) -> Value {
+            using C = std::decay_t<decltype(col)>;
+            if constexpr (std::is_same_v<C, StringColumn>) {
+                return Value(std::string(col[row]));
+            } else {
+                return Value(col[row]);
+            }
+        }, columns_[k]);
+    }
+
+    template <typename T, typename Visit, typename Pred>
+    void scan(std::string_view key, Visit visit, Pred pred) const {
+        using Stored = std::conditional_t<std::is_same_v<T, std::string_view>, StringColumn, std::vector<T>>;
+        auto col = std::get_if<Stored>(&column(key));
+        if (!col) throw std::runtime_error("Column has a different type: " + std::string(key));
+        for (std::size_t i = 0, n = col->size(); i < n; ++i) visit(i, static_cast<bool>(pred((*col)[i])));
+    }
+
+    std::vector<std::string> keys_;
+    std::vector<Column> columns_;
+    std::size_t rows_ = 0;
+};
+
+// Array of numbers held as plain doubles or int32s rather than Values, for
+// bulk numeric data such as per-vertex or per-sample arrays. It is converted
+// to and from Array explicitly, and reads and writes binary LLSD arrays a
+// block of numbers at a time.
+class PackedArray {
+public:
+    using Storage = std::variant<std::vector<double>, std::vector<std::int32_t>>;
+
+    PackedArray() = default;
+    explicit PackedArray(std::vector<double> reals) : storage_(std::move(reals)) {}
+    explicit PackedArray(std::vector<std::int32_t> integers) : storage_(std::move(integers)) {}
+
+    // Packs `array`, or returns nothing unless its elements are all reals or
+    // all integers
+    static std::optional<PackedArray> from_array(const Array& array) {
+        if (array.empty()) return PackedArray();
+        if (std::holds_alternative<double>(array.front().data)) return gather<double>(array);
+        if (std::holds_alternative<std::int32_t>(array.front().data)) return gather<std::int32_t>(array);
+        return std::nullopt;
+    }
+
+    // Reads a binary LLSD array whose elements are all 'r' or all 'i'
+    // tokens; throws on anything else
+    static PackedArray read_binary(std::istream& s) {
+        char type_char = 0;
+        s.get(type_char);
+        if (type_char != '[') throw std::runtime_error("Expected '[' to open packed array");
+        auto size = detail::read_i32_be(s);
+        if (size < 0) throw std::runtime_error("Invalid array size");
+        PackedArray packed;
+        int read = 0;
+        if (size > 0) {
+            if (s.peek() == 'i') {
+                read = detail::read_packed_run(s, size, packed.storage_.emplace<std::vector<std::int32_t>>());
+            } else {
+                read = detail::read_packed_run(s, size, std::get<std::vector<double>>(packed.storage_));
+            }
+        }
+        if (read != size) throw std::runtime_error("Array is not uniformly numeric");
+        s.get(type_char);
+        if (type_char != ']') throw std::runtime_error("Expected ']' to close array");
+        return packed;
+    }
+
+    // Writes the numbers as a binary LLSD array
+    void write_binary(std::ostream& s) const {
+        s.put('[');
+        detail::write_i32_be(s, static_cast<std::int32_t>(size()));
+        std::visit([&](const auto& numbers) { detail::write_packed_run(s, numbers); }, storage_);
+        s.put(']');
+    }
+
+    Array to_array() const {
+        Array array;
+        array.reserve(size());
+        std::visit([&](const auto& numbers) {
+            for (auto n : numbers) array.emplace_back(n);
+        }, storage_);
+        return array;
+    }
+
+    std::size_t size() const { return std::visit([](const auto& numbers) { return numbers.size(); }, storage_); }
+    bool empty() const { return size() == 0; }
+
+    // The element at `i`
+    Value get(std::size_t i) const {
+        return std::visit([i](const auto& numbers) { return Value(numbers[i]); }, storage_);
+    }
+
+    // The numbers, or nullptr when they are of the other type
+    const std::vector<double>* reals() const { return std::get_if<std::vector<double>>(&storage_); }
+    const std::vector<std::int32_t>* integers() const { return std::get_if<std::vector<std::int32_t>>(&storage_); }
+
+    friend bool operator==(const PackedArray& a, const PackedArray& b) { return a.storage_ == b.storage_; }
+    friend bool operator!=(const PackedArray& a, const PackedArray& b) { return !(a == b); }
+
+private:
+    template <typename T>
+    static std::optional<PackedArray> gather(const Array& array) {
+        std::vector<T> numbers;
+        numbers.reserve(array.size());
+        for (const Value& v : array) {
+            auto n = std::get_if<T>(&v.data);
+            if (!n) return std::nullopt;
+            numbers.push_back(*n);
+        }
+        return PackedArray(std::move(numbers));
+    }
+
+    Storage storage_;
+};
+
+// Immutable snapshot of a Value tree that threads can share without locking.
+// Copies share the tree through an atomically reference-counted pointer, and
+// children taken from a snapshot keep the whole tree alive. Nothing reachable
+// from a snapshot is ever modified.
+class SharedValue {
+public:
+    SharedValue() = default;
+    explicit SharedValue(Value v) : ptr_(std::make_shared<const Value>(std::move(v))) {}
+    explicit SharedValue(std::shared_ptr<const Value> ptr) : ptr_(std::move(ptr)) {}
+
+    // Whether this refers to a tree at all
+    explicit operator bool() const { return ptr_ != nullptr; }
+
+    const Value& operator*() const { return *ptr_; }
+    const Value* operator->() const { return ptr_.get(); }
+    const Value* get() const { return ptr_.get(); }
+    const std::shared_ptr<const Value>& ptr() const { return ptr_; }
+
+    // The entry `key` of a map, sharing this snapshot's tree; empty if this is
+    // not a map or has no such key
+    SharedValue operator[](std::string_view key) const {
+        auto map = ptr_ ? std::get_if<std::unique_ptr<Map>>(&ptr_->data) : nullptr;
+        if (!map || !*map) return SharedValue();
+        const Map& entries = **map;
+        auto it = entries.find(key);
+        if (it == entries.end()) return SharedValue();
+        return SharedValue(std::shared_ptr<const Value>(ptr_, &it->second));
+    }
+
+    // Element `i` of an array, sharing this snapshot's tree; empty if this is
+    // not an array or `i` is out of range
+    SharedValue operator[](std::size_t i) const {
+        auto array = ptr_ ? std::get_if<std::unique_ptr<Array>>(&ptr_->data) : nullptr;
+        if (!array || !*array || i >= (*array)->size()) return SharedValue();
+        return SharedValue(std::shared_ptr<const Value>(ptr_, &(**array)[i]));
+    }
+
+    // A mutable deep copy, for building the next version
+    Value thaw() const { return ptr_ ? Value(*ptr_) : Value(); }
+
+    long use_count() const { return ptr_.use_count(); }
+
+private:
+    std::shared_ptr<const Value> ptr_;
+};
+
+// Slot holding the current SharedValue: writers publish new versions while
+// readers load whichever is current, and each version lives until its last
+// reader drops it
+class SharedValueSlot {
+public:
+    SharedValueSlot() = default;
+    explicit SharedValueSlot(SharedValue initial) : ptr_(initial.ptr()) {}
+
+    SharedValueSlot(const SharedValueSlot&) = delete;
+    SharedValueSlot& operator=(const SharedValueSlot&) = delete;
+
+    SharedValue load() const {
+#if defined(__cpp_lib_atomic_shared_ptr)
+        return SharedValue(ptr_.load());
+#else
+        return SharedValue(std::atomic_load(&ptr_));
+#endif
+    }
+
+    void store(const SharedValue& v) {
+#if defined(__cpp_lib_atomic_shared_ptr)
+        ptr_.store(v.ptr());
+#else
+        std::atomic_store(&ptr_, v.ptr());
+#endif
+    }
+
+    // Publishes `v`, returning the version it replaced
+    SharedValue exchange(const SharedValue& v) {
+#if defined(__cpp_lib_atomic_shared_ptr)
+        return SharedValue(ptr_.exchange(v.ptr()));
+#else
+        return SharedValue(std::atomic_exchange(&ptr_, v.ptr()));
+#endif
+    }
+
+    // Publishes `desired` only if `expected` is still current; otherwise
+    // loads the current version into `expected`
+    bool compare_exchange(SharedValue& expected, const SharedValue& desired) {
+        std::shared_ptr<const Value> current = expected.ptr();
+#if defined(__cpp_lib_atomic_shared_ptr)
+        bool swapped = ptr_.compare_exchange_strong(current, desired.ptr());
+#else
+        bool swapped = std::atomic_compare_exchange_strong(&ptr_, &current, desired.ptr());
+#endif
+        if (!swapped) expected = SharedValue(std::move(current));
+        return swapped;
+    }
+
+    // Applies `update` to a copy of the current version and publishes the
+    // result, retrying if another writer published first
+    template <typename Fn>
+    SharedValue update(Fn update) {
+        SharedValue current = load();
+        for (;;) {
+            Value next = current.thaw();
+            update(next);
+            SharedValue desired(std::move(next));
+            if (compare_exchange(current, desired)) return desired;
+        }
+    }
+
+private:
+#if defined(__cpp_lib_atomic_shared_ptr)
+    std::atomic<std::shared_ptr<const Value>> ptr_;
+#else
+    std::shared_ptr<const Value> ptr_;
+#endif
+};
+
+} // namespace llsd_modern
+
+template <>
+struct std::hash<llsd_modern::Value> {
+    std::size_t operator()(const llsd_modern::Value& v) const { return v.hash(); }
+};
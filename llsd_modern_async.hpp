@@ -0,0 +1,658 @@
+/**
+ * @file llsd_modern_async.hpp
+ * @brief Coroutine-based binary LLSD reading and writing over non-blocking
+ * file descriptors, for llsd_modern.hpp.
+ *
+ * Copyright (c) 2025 humbletim
+ *
+ * This library is licensed under the MIT License.
+ *
+ * Requires C++20 coroutines and Linux (epoll).
+ */
+#pragma once
+
+#if !defined(__cpp_impl_coroutine) || !defined(__linux__)
+#error "llsd_modern_async.hpp requires C++20 coroutines and Linux"
+#endif
+
+#include "llsd_modern.hpp"
+#include <cerrno>
+#include <coroutine>
+#include <cstring>
+#include <exception>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace llsd_modern {
+
+template<typename T = void>
+class Task;
+
+namespace detail {
+
+// State shared by every Task promise: who to resume when done, and the
+// exception to rethrow there
+struct TaskPromiseBase {
+    struct FinalAwaiter {
+        bool await_ready() noexcept { return false; }
+        template<typename Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> h) noexcept {
+            auto continuation = h.promise().continuation;
+            return continuation ? continuation : std::noop_coroutine();
+        }
+        void await_resume() noexcept {}
+    };
+
+    std::suspend_always initial_suspend() noexcept { return {}; }
+    FinalAwaiter final_suspend() noexcept { return {}; }
+    void unhandled_exception() { error = std::current_exception(); }
+
+    std::coroutine_handle<> continuation;
+    std::exception_ptr error;
+};
+
+template<typename T>
+struct TaskPromise : TaskPromiseBase {
+    Task<T> get_return_object();
+    template<typename U>
+    void return_value(U&& v) { result.emplace(std::forward<U>(v)); }
+    T take() {
+        if (error) std::rethrow_exception(error);
+        return std::move(*result);
+    }
+    std::optional<T> result;
+};
+
+template<>
+struct TaskPromise<void> : TaskPromiseBase {
+    Task<void> get_return_object();
+    void return_void() {}
+    void take() {
+        if (error) std::rethrow_exception(error);
+    }
+};
+
+} // namespace detail
+
+// Lazily started coroutine producing a T. Awaiting it runs it to completion
+// (suspending wherever it suspends) and yields its result or rethrows its
+// exception; EventLoop::spawn runs one without an awaiting coroutine.
+template<typename T>
+class Task {
+public:
+    using promise_type = detail::TaskPromise<T>;
+
+    explicit Task(std::coroutine_handle<promise_type> h) : handle_(h) {}
+    Task(Task&& other) noexcept : handle_(std::exchange(other.handle_, {})) {}
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            if (handle_) handle_.destroy();
+            handle_ = std::exchange(other.handle_, {});
+        }
+        return *this;
+    }
+    ~Task() {
+        if (handle_) handle_.destroy();
+    }
+
+    bool await_ready() const noexcept { return false; }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+        handle_.promise().continuation = awaiting;
+        return handle_;
+    }
+    T await_resume() { return handle_.promise().take(); }
+
+private:
+    std::coroutine_handle<promise_type> handle_;
+};
+
+namespace detail {
+
+template<typename T>
+Task<T> TaskPromise<T>::get_return_object() {
+    return Task<T>(std::coroutine_handle<TaskPromise<T>>::from_promise(*this));
+}
+
+inline Task<void> TaskPromise<void>::get_return_object() {
+    return Task<void>(std::coroutine_handle<TaskPromise<void>>::from_promise(*this));
+}
+
+// Fire-and-forget coroutine that frees itself when it finishes
+struct Detached {
+    struct promise_type {
+        Detached get_return_object() { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+};
+
+inline std::runtime_error errno_error(const char* what) {
+    return std::runtime_error(std::string(what) + ": " + std::strerror(errno));
+}
+
+} // namespace detail
+
+// Single-threaded epoll loop that resumes coroutines when the descriptor
+// they wait on becomes readable or writable
+class EventLoop {
+public:
+    EventLoop() : epoll_fd_(::epoll_create1(EPOLL_CLOEXEC)) {
+        if (epoll_fd_ < 0) throw detail::errno_error("epoll_create1");
+    }
+    ~EventLoop() { ::close(epoll_fd_); }
+
+    EventLoop(const EventLoop&) = delete;
+    EventLoop& operator=(const EventLoop&) = delete;
+
+    // Awaitable that suspends until `fd` is readable (or has hung up)
+    auto readable(int fd) { return Wait{*this, fd, EPOLLIN}; }
+    // Awaitable that suspends until `fd` is writable (or has failed)
+    auto writable(int fd) { return Wait{*this, fd, EPOLLOUT}; }
+
+    // Starts `task` now, running it up to its first suspension; run() keeps
+    // going until it and every other spawned task have finished
+    void spawn(Task<void> task) {
+        ++active_;
+        [](EventLoop& loop, Task<void> task) -> detail::Detached {
+            try {
+                co_await task;
+            } catch (...) {
+                if (!loop.error_) loop.error_ = std::current_exception();
+            }
+            --loop.active_;
+        }(*this, std::move(task));
+    }
+
+    // Dispatches readiness events until every spawned task has finished.
+    // Rethrows the first exception a spawned task let escape.
+    void run() {
+        epoll_event events[64];
+        while (active_ > 0 && !error_) {
+            if (waiting_ == 0) throw std::runtime_error("EventLoop: tasks are suspended on nothing");
+            int n = ::epoll_wait(epoll_fd_, events, 64, -1);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                throw detail::errno_error("epoll_wait");
+            }
+            for (int i = 0; i < n; ++i) dispatch(events[i].data.fd, events[i].events);
+        }
+        if (error_) std::rethrow_exception(std::exchange(error_, nullptr));
+    }
+
+    // Stops watching `fd`; call before closing it
+    void forget(int fd) {
+        auto it = watches_.find(fd);
+        if (it == watches_.end()) return;
+        waiting_ -= (it->second.reader ? 1 : 0) + (it->second.writer ? 1 : 0);
+        ::epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+        watches_.erase(it);
+    }
+
+private:
+    struct Watch {
+        std::coroutine_handle<> reader, writer;
+        bool registered = false;
+    };
+
+    struct Wait {
+        EventLoop& loop;
+        int fd;
+        std::uint32_t events;
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> h) { loop.watch(fd, events, h); }
+        void await_resume() const noexcept {}
+    };
+
+    void watch(int fd, std::uint32_t events, std::coroutine_handle<> h) {
+        Watch& w = watches_[fd];
+        auto& slot = events == EPOLLIN ? w.reader : w.writer;
+        if (slot) throw std::runtime_error("EventLoop: descriptor already has a waiter in that direction");
+        slot = h;
+        ++waiting_;
+        arm(fd, w);
+    }
+
+    // Registers the interest of `w`'s waiters as a one-shot event, so a
+    // descriptor fires once per wait
+    void arm(int fd, Watch& w) {
+        epoll_event ev{};
+        ev.events = EPOLLONESHOT | (w.reader ? static_cast<std::uint32_t>(EPOLLIN) : 0u) |
+                    (w.writer ? static_cast<std::uint32_t>(EPOLLOUT) : 0u);
+        ev.data.fd = fd;
+        if (::epoll_ctl(epoll_fd_, w.registered ? EPOLL_CTL_MOD : EPOLL_CTL_ADD, fd, &ev) != 0) {
+            throw detail::errno_error("epoll_ctl");
+        }
+        w.registered = true;
+    }
+
+    void dispatch(int fd, std::uint32_t events) {
+        auto it = watches_.find(fd);
+        if (it == watches_.end()) return;
+        Watch& w = it->second;
+        const bool failed = events & (EPOLLERR | EPOLLHUP);
+        std::coroutine_handle<> reader, writer;
+        if (w.reader && (failed || (events & EPOLLIN))) reader = std::exchange(w.reader, {});
+        if (w.writer && (failed || (events & EPOLLOUT))) writer = std::exchange(w.writer, {});
+        waiting_ -= (reader ? 1 : 0) + (writer ? 1 : 0);
+        if (w.reader || w.writer) arm(fd, w);
+        // Resuming may forget `fd`, so `w` is not touched after this
+        if (reader) reader.resume();
+        if (writer) writer.resume();
+    }
+
+    int epoll_fd_;
+    std::unordered_map<int, Watch> watches_;
+    std::size_t waiting_ = 0;
+    std::size_t active_ = 0;
+    std::exception_ptr error_;
+};
+
+namespace detail {
+
+// Incremental binary LLSD decoder: feed() takes the bytes as they arrive and
+// builds the document's tree as it goes, so nothing but an unfinished token
+// is ever held back. String and binary payloads are collected straight into
+// their Values, however many feeds they span.
+class BinaryDecoder {
+public:
+    // Decodes what it can of `size` bytes and returns how many it used. It
+    // stops once a document is complete (see done()), and may leave fewer
+    // than kMaxToken bytes of an unfinished token for the caller to feed
+    // again with more appended. Throws on malformed input.
+    std::size_t feed(const char* data, std::size_t size) {
+        std::size_t pos = 0;
+        while (!result_) {
+            if (payload_token_) {
+                std::size_t n = std::min(size - pos, payload_size_ - payload_.size());
+                payload_.append(data + pos, n);
+                pos += n;
+                if (payload_.size() < payload_size_) return pos;
+                finish_payload();
+                continue;
+            }
+            const char* p = data + pos;
+            std::size_t avail = size - pos;
+            if (!stack_.empty() && stack_.back().remaining == 0) {
+                if (avail < 1) return pos;
+                Frame& top = stack_.back();
+                if (*p != top.close) {
+                    throw std::runtime_error(top.close == ']' ? "Expected ']' to close array" : "Expected '}' to close map");
+                }
+                ++pos;
+                Value done = std::move(top.container);
+                stack_.pop_back();
+                complete(std::move(done));
+                continue;
+            }
+            if (!stack_.empty() && stack_.back().close == '}' && !stack_.back().have_key) {
+                if (avail < 5) return pos;
+                if (*p != 'k') throw std::runtime_error("Expected 'k' for map key");
+                start_payload('k', read_count(p + 1));
+                pos += 5;
+                continue;
+            }
+            if (avail < 1) return pos;
+            std::size_t length = token_length(*p);
+            if (avail < length) return pos;
+            switch (*p) {
+                case 's': case 'l': case 'b':
+                    start_payload(*p, read_count(p + 1));
+                    break;
+                case '[': case '{': {
+                    std::uint32_t count = static_cast<std::uint32_t>(read_count(p + 1));
+                    Frame frame{Value(), count, *p == '[' ? ']' : '}', false, {}};
+                    if (*p == '[') {
+                        auto array = std::make_unique<Array>();
+                        // The count is untrusted, so only reserve what a
+                        // small array needs
+                        array->reserve(std::min<std::uint32_t>(count, 64));
+                        frame.container = Value(std::move(array));
+                    } else {
+                        auto map = std::make_unique<Map>();
+                        map->reserve(count);
+                        frame.container = Value(std::move(map));
+                    }
+                    stack_.push_back(std::move(frame));
+                    break;
+                }
+                default: {
+                    ViewStreambuf buf(std::string_view(p + 1, length - 1));
+                    std::istream in(&buf);
+                    complete(read_binary_scalar(in, *p));
+                }
+            }
+            pos += length;
+        }
+        return pos;
+    }
+
+    // Longest token prefix feed() may need to see whole: 'u' and its UUID
+    static constexpr std::size_t kMaxToken = 17;
+
+    // Whether a document has been completed and is waiting in take()
+    bool done() const { return result_.has_value(); }
+
+    // Whether no bytes of a document have been decoded yet
+    bool idle() const { return !result_ && stack_.empty() && !payload_token_; }
+
+    // The completed document; the decoder then starts on the next one
+    Value take() {
+        Value v = std::move(*result_);
+        result_.reset();
+        return v;
+    }
+
+private:
+    struct Frame {
+        Value container;         // the Array or Map being filled
+        std::uint32_t remaining; // values (or map entries) still to come
+        char close;              // closing token
+        bool have_key;           // a map entry's key has been decoded
+        std::string key;         // that key, until its value completes
+    };
+
+    // Bytes a token and its fixed-size payload or length take
+    static std::size_t token_length(char token) {
+        switch (token) {
+            case '!': case '0': case '1': return 1;
+            case 'i': case 's': case 'l': case 'b': case '[': case '{': return 5;
+            case 'r': case 'd': return 9;
+            case 'u': return 17;
+            default: throw std::runtime_error("Invalid binary token");
+        }
+    }
+
+    static std::int32_t read_count(const char* p) {
+        std::uint32_t u = 0;
+        for (int i = 0; i < 4; ++i) u = (u << 8) | static_cast<unsigned char>(p[i]);
+        auto count = static_cast<std::int32_t>(u);
+        if (count < 0) throw std::runtime_error("Invalid binary size");
+        return count;
+    }
+
+    void start_payload(char token, std::int32_t size) {
+        payload_token_ = token;
+        payload_size_ = static_cast<std::size_t>(size);
+        payload_.clear();
+        // As with the array count, grow towards an untrusted size as the
+        // bytes actually arrive
+        payload_.reserve(std::min<std::size_t>(payload_size_, 64 * 1024));
+    }
+
+    void finish_payload() {
+        char token = std::exchange(payload_token_, 0);
+        if (token == 'k') {
+            stack_.back().key = std::move(payload_);
+            stack_.back().have_key = true;
+        } else if (token == 's') {
+            complete(Value(std::move(payload_)));
+        } else if (token == 'l') {
+            complete(Value(URI{std::move(payload_)}));
+        } else {
+            complete(Value(Binary{std::vector<std::uint8_t>(payload_.begin(), payload_.end())}));
+        }
+        payload_ = std::string();
+    }
+
+    // Adds a finished value to the enclosing container, or makes it the
+    // result
+    void complete(Value v) {
+        if (stack_.empty()) {
+            result_.emplace(std::move(v));
+            return;
+        }
+        Frame& top = stack_.back();
+        if (top.close == ']') {
+            std::get<std::unique_ptr<Array>>(top.container.data)->push_back(std::move(v));
+        } else {
+            (*std::get<std::unique_ptr<Map>>(top.container.data))[std::move(top.key)] = std::move(v);
+            top.have_key = false;
+        }
+        --top.remaining;
+    }
+
+    std::vector<Frame> stack_;
+    std::optional<Value> result_;
+    std::string payload_;
+    std::size_t payload_size_ = 0;
+    char payload_token_ = 0; // 's', 'l', 'b' or 'k' while collecting a payload
+};
+
+// Incremental binary LLSD encoder: fill() writes the next part of the
+// document into a caller-supplied buffer and picks up where it stopped on the
+// next call, so a document of any size goes out through one fixed-size
+// buffer. The output matches format_binary's byte for byte.
+class BinaryEncoder {
+public:
+    explicit BinaryEncoder(const Value& v) : root_(&v) {}
+
+    // Writes up to `size` bytes to `out` and returns how many, which is fewer
+    // only once the document is done
+    std::size_t fill(char* out, std::size_t size) {
+        std::size_t pos = 0;
+        while (pos < size) {
+            if (head_pos_ < head_len_) {
+                std::size_t n = std::min(size - pos, head_len_ - head_pos_);
+                std::memcpy(out + pos, head_ + head_pos_, n);
+                head_pos_ += n;
+                pos += n;
+            } else if (payload_pos_ < payload_.size()) {
+                std::size_t n = std::min(size - pos, payload_.size() - payload_pos_);
+                std::memcpy(out + pos, payload_.data() + payload_pos_, n);
+                payload_pos_ += n;
+                pos += n;
+            } else if (!next()) {
+                break;
+            }
+        }
+        return pos;
+    }
+
+    // Whether every byte of the document has been written
+    bool done() const { return finished_ && head_pos_ == head_len_ && payload_pos_ == payload_.size(); }
+
+private:
+    struct Frame {
+        const Array* array;
+        std::size_t index;
+        Map::const_iterator it, end;
+        bool key_done;
+    };
+
+    // Sets up the next token, returning false once there are no more
+    bool next() {
+        head_len_ = head_pos_ = payload_pos_ = 0;
+        payload_ = std::string_view();
+        if (root_) {
+            emit(*std::exchange(root_, nullptr));
+            return true;
+        }
+        if (stack_.empty()) {
+            finished_ = true;
+            return false;
+        }
+        Frame& top = stack_.back();
+        if (top.array) {
+            if (top.index < top.array->size()) {
+                emit((*top.array)[top.index++]);
+            } else {
+                head_[head_len_++] = ']';
+                stack_.pop_back();
+            }
+        } else if (top.it == top.end) {
+            head_[head_len_++] = '}';
+            stack_.pop_back();
+        } else if (!top.key_done) {
+            top.key_done = true;
+            put_sized('k', top.it->first);
+        } else {
+            top.key_done = false;
+            emit((top.it++)->second);
+        }
+        return true;
+    }
+
+    void emit(const Value& v) {
+        std::visit([&](const auto& arg) {
+            using T = std::decay_t<decltype(arg)>;
+            if constexpr (std::is_same_v<T, Undef>) {
+                head_[head_len_++] = '!';
+            } else if constexpr (std::is_same_v<T, bool>) {
+                head_[head_len_++] = arg ? '1' : '0';
+            } else if constexpr (std::is_same_v<T, std::int32_t>) {
+                head_[head_len_++] = 'i';
+                put_be(static_cast<std::uint32_t>(arg));
+            } else if constexpr (std::is_same_v<T, double>) {
+                head_[head_len_++] = 'r';
+                put_double(arg, true);
+            } else if constexpr (std::is_same_v<T, std::string>) {
+                put_sized('s', arg);
+            } else if constexpr (std::is_same_v<T, LLUUID>) {
+                head_[head_len_++] = 'u';
+                std::memcpy(head_ + head_len_, arg.bytes().data(), 16);
+                head_len_ += 16;
+            } else if constexpr (std::is_same_v<T, LLDate>) {
+                head_[head_len_++] = 'd';
+                put_double(std::chrono::duration<double>(arg.timePoint().time_since_epoch()).count(), false);
+            } else if constexpr (std::is_same_v<T, URI>) {
+                put_sized('l', arg.s);
+            } else if constexpr (std::is_same_v<T, Binary>) {
+                put_sized('b', std::string_view(reinterpret_cast<const char*>(arg.b.data()), arg.b.size()));
+            } else if constexpr (std::is_same_v<T, std::unique_ptr<Array>>) {
+                head_[head_len_++] = '[';
+                put_be(static_cast<std::uint32_t>(arg ? arg->size() : 0));
+                if (arg && !arg->empty()) {
+                    stack_.push_back(Frame{arg.get(), 0, {}, {}, false});
+                } else {
+                    head_[head_len_++] = ']';
+                }
+            } else if constexpr (std::is_same_v<T, std::unique_ptr<Map>>) {
+                head_[head_len_++] = '{';
+                put_be(static_cast<std::uint32_t>(arg ? arg->size() : 0));
+                if (arg && !arg->empty()) {
+                    stack_.push_back(Frame{nullptr, 0, arg->begin(), arg->end(), false});
+                } else {
+                    head_[head_len_++] = '}';
+                }
+            }
+        }, v.data);
+    }
+
+    void put_sized(char token, std::string_view payload) {
+        head_[head_len_++] = token;
+        put_be(static_cast<std::uint32_t>(payload.size()));
+        payload_ = payload;
+    }
+
+    void put_be(std::uint32_t u) {
+        for (int i = 3; i >= 0; --i) head_[head_len_++] = static_cast<char>(u >> (8 * i));
+    }
+
+    // Binary LLSD reals are big-endian; dates are little-endian
+    void put_double(double d, bool big_endian) {
+        std::uint64_t u;
+        std::memcpy(&u, &d, sizeof u);
+        for (int i = 0; i < 8; ++i) {
+            int shift = big_endian ? 8 * (7 - i) : 8 * i;
+            head_[head_len_++] = static_cast<char>(u >> shift);
+        }
+    }
+
+    const Value* root_;
+    std::vector<Frame> stack_;
+    char head_[17];
+    std::size_t head_len_ = 0, head_pos_ = 0;
+    std::string_view payload_;
+    std::size_t payload_pos_ = 0;
+    bool finished_ = false;
+};
+
+} // namespace detail
+
+// Binary LLSD documents read from and written to one non-blocking file
+// descriptor (typically a socket) on an EventLoop. Documents are decoded as
+// their bytes arrive and encoded as the descriptor takes them, so each
+// direction needs only one `chunk_size` buffer however large the documents
+// are. The descriptor stays owned by the caller. At most one read and one
+// write may be in progress at a time.
+class AsyncBinaryStream {
+public:
+    AsyncBinaryStream(EventLoop& loop, int fd, std::size_t chunk_size = 64 * 1024)
+        : loop_(loop), fd_(fd), chunk_size_(std::max(chunk_size, 2 * detail::BinaryDecoder::kMaxToken)) {}
+    ~AsyncBinaryStream() { loop_.forget(fd_); }
+
+    AsyncBinaryStream(const AsyncBinaryStream&) = delete;
+    AsyncBinaryStream& operator=(const AsyncBinaryStream&) = delete;
+
+    // Reads the next document, suspending whenever the descriptor has no
+    // data yet. Returns nothing at a clean end of stream between documents;
+    // throws if the stream ends inside one.
+    Task<std::optional<Value>> read() {
+        if (in_.empty()) in_.resize(chunk_size_);
+        for (;;) {
+            begin_ += decoder_.feed(in_.data() + begin_, end_ - begin_);
+            if (decoder_.done()) co_return std::optional<Value>(decoder_.take());
+            // What is left is part of one token; keep it at the front
+            std::memmove(in_.data(), in_.data() + begin_, end_ - begin_);
+            end_ -= begin_;
+            begin_ = 0;
+            ssize_t n = ::read(fd_, in_.data() + end_, in_.size() - end_);
+            if (n > 0) {
+                end_ += static_cast<std::size_t>(n);
+            } else if (n == 0) {
+                if (end_ == 0 && decoder_.idle()) co_return std::nullopt;
+                throw std::runtime_error("Unexpected end of stream");
+            } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                co_await loop_.readable(fd_);
+            } else if (errno != EINTR) {
+                throw detail::errno_error("read");
+            }
+        }
+    }
+
+    // Writes `v`, suspending whenever the descriptor cannot take more bytes
+    // and resuming a partial write where it stopped
+    Task<void> write(const Value& v) {
+        if (out_.empty()) out_.resize(chunk_size_);
+        detail::BinaryEncoder encoder(v);
+        while (!encoder.done()) {
+            std::size_t size = encoder.fill(out_.data(), out_.size());
+            std::size_t done = 0;
+            while (done < size) {
+                ssize_t n = send(out_.data() + done, size - done);
+                if (n >= 0) {
+                    done += static_cast<std::size_t>(n);
+                } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                    co_await loop_.writable(fd_);
+                } else if (errno != EINTR) {
+                    throw detail::errno_error("write");
+                }
+            }
+        }
+    }
+
+private:
+    // Writes without raising SIGPIPE on sockets, falling back to write(2)
+    // for pipes and other descriptors
+    ssize_t send(const char* data, std::size_t size) {
+        if (is_socket_) {
+            ssize_t n = ::send(fd_, data, size, MSG_NOSIGNAL);
+            if (n >= 0 || errno != ENOTSOCK) return n;
+            is_socket_ = false;
+        }
+        return ::write(fd_, data, size);
+    }
+
+    EventLoop& loop_;
+    int fd_;
+    std::size_t chunk_size_;
+    std::vector<char> in_, out_;
+    std::size_t begin_ = 0, end_ = 0;
+    detail::BinaryDecoder decoder_;
+    bool is_socket_ = true;
+};
+
+} // namespace llsd_modern
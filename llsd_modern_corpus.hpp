@@ -0,0 +1,352 @@
+/**
+ * @file llsd_modern_corpus.hpp
+ * @brief Deterministic synthetic LLSD documents for benchmarks and
+ * differential testing of llsd_modern.hpp.
+ *
+ * Copyright (c) 2025 humbletim
+ *
+ * This library is licensed under the MIT License.
+ */
+#pragma once
+
+#include "llsd_modern.hpp"
+
+namespace llsd_modern {
+
+// Shapes of document modeled on viewer/simulator traffic
+enum class CorpusKind {
+    EventQueue,       // batches of event-queue messages
+    InventoryTree,    // nested inventory folders with their items
+    ObjectProperties, // object property lists: UUIDs, names, vectors
+    Appearance,       // avatar appearance: texture UUIDs and parameter blobs
+    NestedConfig,     // deeply nested free-form settings
+};
+
+// Tuning for CorpusGenerator. The same options (seed included) always give
+// the same documents, on every platform.
+struct CorpusOptions {
+    std::uint64_t seed = 1;
+    std::size_t scale = 16;       // messages, objects, items per folder, ...
+    std::size_t max_depth = 6;    // nesting limit for folders and config trees
+    std::size_t key_pool = 64;    // distinct free-form keys; fewer means more repetition
+    std::size_t max_string = 32;  // longest generated string, in bytes
+    std::size_t max_binary = 256; // longest free-form binary blob
+    // Relative frequency of each kind of free-form scalar
+    unsigned string_weight = 4;
+    unsigned uuid_weight = 2;
+    unsigned binary_weight = 1;
+    unsigned number_weight = 4;  // integers and reals
+    unsigned other_weight = 1;   // undef, booleans, dates and URIs
+};
+
+// Produces synthetic LLSD documents from a seeded generator. Each call
+// continues the same random sequence, so a generator replays identically
+// from the same options.
+class CorpusGenerator {
+public:
+    explicit CorpusGenerator(const CorpusOptions& options = CorpusOptions())
+        : options_(options), state_(options.seed) {}
+
+    Value generate(CorpusKind kind) {
+        switch (kind) {
+            case CorpusKind::EventQueue: return event_queue();
+            case CorpusKind::InventoryTree: return inventory_folder(0);
+            case CorpusKind::ObjectProperties: return object_properties();
+            case CorpusKind::Appearance: return appearance();
+            case CorpusKind::NestedConfig: return config(0);
+        }
+        throw std::runtime_error("Unknown corpus kind");
+    }
+
+    std::vector<Value> generate(CorpusKind kind, std::size_t count) {
+        std::vector<Value> docs;
+        docs.reserve(count);
+        for (std::size_t i = 0; i < count; ++i) docs.push_back(generate(kind));
+        return docs;
+    }
+
+    // `count` documents cycling through every kind
+    std::vector<Value> mixed(std::size_t count) {
+        std::vector<Value> docs;
+        docs.reserve(count);
+        for (std::size_t i = 0; i < count; ++i) docs.push_back(generate(static_cast<CorpusKind>(i % 5)));
+        return docs;
+    }
+
+private:
+    // splitmix64: small, fast and the same everywhere, unlike the
+    // distributions in <random>
+    std::uint64_t next() {
+        std::uint64_t z = (state_ += 0x9e3779b97f4a7c15ULL);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        return z ^ (z >> 31);
+    }
+    // Uniform in [0, n)
+    std::size_t below(std::size_t n) { return n ? static_cast<std::size_t>(next() % n) : 0; }
+    // Uniform in [lo, hi]
+    std::int32_t between(std::int32_t lo, std::int32_t hi) {
+        // Offset in 64 bits: the full int32 range overflows int32 arithmetic
+        std::uint64_t span = static_cast<std::uint64_t>(std::int64_t(hi) - lo) + 1;
+        return static_cast<std::int32_t>(lo + static_cast<std::int64_t>(next() % span));
+    }
+    bool chance(unsigned percent) { return below(100) < percent; }
+
+    static std::unique_ptr<Map> map() { return std::make_unique<Map>(); }
+    static std::unique_ptr<Array> array() { return std::make_unique<Array>(); }
+
+    // Fills `size` bytes from the sequence, independent of byte order
+    void fill(std::uint8_t* out, std::size_t size) {
+        std::uint64_t r = 0;
+        for (std::size_t i = 0; i < size; ++i) {
+            if (i % 8 == 0) r = next();
+            out[i] = static_cast<std::uint8_t>(r >> (8 * (i % 8)));
+        }
+    }
+
+    LLUUID uuid() {
+        std::array<std::uint8_t, 16> bytes;
+        fill(bytes.data(), bytes.size());
+        bytes[6] = static_cast<std::uint8_t>((bytes[6] & 0x0f) | 0x40); // version 4
+        bytes[8] = static_cast<std::uint8_t>((bytes[8] & 0x3f) | 0x80);
+        return LLUUID(bytes);
+    }
+
+    // Whole seconds between 2004 and 2030, which every format represents
+    // exactly
+    LLDate date() {
+        auto seconds = std::chrono::seconds(1072915200 + static_cast<std::int64_t>(below(820000000)));
+        return LLDate(std::chrono::system_clock::time_point(
+            std::chrono::duration_cast<std::chrono::system_clock::duration>(seconds)));
+    }
+
+    double real() {
+        switch (below(3)) {
+            case 0: return between(-100000, 100000) / 100.0;
+            case 1: return static_cast<double>(between(-1000, 1000));
+            default: {
+                // Full-precision value in (-1e6, 1e6)
+                double unit = static_cast<double>(next() >> 11) / 9007199254740992.0;
+                return (unit * 2 - 1) * 1e6;
+            }
+        }
+    }
+
+    std::string text(std::size_t max_size) {
+        // Mostly plain words, sometimes with characters every format must escape
+        static const char* const kWords[] = {"Ahern", "Bogus", "Morris", "sandbox", "welcome", "region",
+                                             "object", "prim", "avatar", "notecard", "texture", "script"};
+        static const char* const kSpecials[] = {"\"", "\\", "<", ">", "&", "'", "\n", "\t", "\xc3\xa9",
+                                                "\xe6\x97\xa5\xe6\x9c\xac"};
+        std::string s;
+        std::size_t target = below(max_size + 1);
+        while (s.size() < target) {
+            if (!s.empty()) s += ' ';
+            s += chance(10) ? kSpecials[below(std::size(kSpecials))] : kWords[below(std::size(kWords))];
+        }
+        return s;
+    }
+
+    Binary blob(std::size_t size) {
+        Binary b;
+        b.b.resize(size);
+        fill(b.b.data(), size);
+        return b;
+    }
+
+    std::string key() {
+        static const char* const kStems[] = {"enabled", "limit", "name", "mode", "scale", "url",
+                                             "timeout", "color", "id", "level", "path", "flags"};
+        std::size_t k = below(std::max<std::size_t>(1, options_.key_pool));
+        std::string s = kStems[k % std::size(kStems)];
+        if (k >= std::size(kStems)) s += "_" + std::to_string(k / std::size(kStems));
+        return s;
+    }
+
+    // A vector of `n` reals
+    Value vector(std::size_t n) {
+        auto v = array();
+        v->reserve(n);
+        for (std::size_t i = 0; i < n; ++i) v->push_back(Value(real()));
+        return Value(std::move(v));
+    }
+
+    // A free-form scalar drawn according to the weights in the options
+    Value scalar() {
+        const unsigned weights[] = {options_.string_weight, options_.uuid_weight, options_.binary_weight,
+                                    options_.number_weight, options_.other_weight};
+        unsigned total = 0;
+        for (unsigned w : weights) total += w;
+        std::size_t pick = below(total ? total : 1);
+        std::size_t kind = 0;
+        while (kind < 4 && pick >= weights[kind]) pick -= weights[kind++];
+        switch (kind) {
+            case 0: return Value(text(options_.max_string));
+            case 1: return Value(uuid());
+            case 2: return Value(blob(below(options_.max_binary + 1)));
+            case 3: return chance(50) ? Value(between(INT32_MIN, INT32_MAX)) : Value(real());
+            default:
+                switch (below(4)) {
+                    case 0: return Value();
+                    case 1: return Value(chance(50));
+                    case 2: return Value(date());
+                    default: return Value(URI{"http://example.com/" + text(12)});
+                }
+        }
+    }
+
+    Value event_queue() {
+        static const char* const kMessages[] = {"AgentUpdate", "ChatterBoxInvitation", "EstablishAgentCommunication",
+                                                "ParcelProperties", "TeleportFinish", "ObjectPhysicsProperties"};
+        auto events = array();
+        std::size_t count = 1 + below(std::max<std::size_t>(1, options_.scale));
+        for (std::size_t i = 0; i < count; ++i) {
+            auto body = map();
+            (*body)["agent_id"] = Value(uuid());
+            (*body)["region_handle"] = Value(blob(8));
+            (*body)["position"] = vector(3);
+            // Draws are kept in separate statements so their order is fixed
+            std::size_t subnet = below(256), host = below(256);
+            (*body)["sim_ip"] = Value("10.0." + std::to_string(subnet) + "." + std::to_string(host));
+            for (std::size_t extra = below(4); extra > 0; --extra) {
+                std::string k = key();
+                (*body)[k] = scalar();
+            }
+            auto event = map();
+            (*event)["message"] = Value(std::string(kMessages[below(std::size(kMessages))]));
+            (*event)["body"] = Value(std::move(body));
+            events->push_back(Value(std::move(event)));
+        }
+        auto doc = map();
+        (*doc)["events"] = Value(std::move(events));
+        (*doc)["id"] = Value(between(0, 1 << 20));
+        return Value(std::move(doc));
+    }
+
+    Value inventory_item(const LLUUID& parent) {
+        auto permissions = map();
+        (*permissions)["owner_id"] = Value(uuid());
+        (*permissions)["creator_id"] = Value(uuid());
+        (*permissions)["base_mask"] = Value(between(0, INT32_MAX));
+        (*permissions)["owner_mask"] = Value(between(0, INT32_MAX));
+        (*permissions)["everyone_mask"] = Value(between(0, 1 << 16));
+        auto sale = map();
+        (*sale)["sale_price"] = Value(between(0, 1000));
+        (*sale)["sale_type"] = Value(between(0, 3));
+        auto item = map();
+        (*item)["item_id"] = Value(uuid());
+        (*item)["parent_id"] = Value(parent);
+        (*item)["asset_id"] = Value(uuid());
+        (*item)["name"] = Value(text(options_.max_string));
+        (*item)["desc"] = Value(text(options_.max_string));
+        (*item)["type"] = Value(between(0, 56));
+        (*item)["inv_type"] = Value(between(0, 25));
+        (*item)["flags"] = Value(between(0, INT32_MAX));
+        (*item)["created_at"] = Value(date());
+        (*item)["permissions"] = Value(std::move(permissions));
+        (*item)["sale_info"] = Value(std::move(sale));
+        return Value(std::move(item));
+    }
+
+    Value inventory_folder(std::size_t depth) {
+        LLUUID id = uuid();
+        auto items = array();
+        for (std::size_t n = below(options_.scale + 1); n > 0; --n) items->push_back(inventory_item(id));
+        auto categories = array();
+        if (depth + 1 < options_.max_depth) {
+            for (std::size_t n = below(4); n > 0; --n) categories->push_back(inventory_folder(depth + 1));
+        }
+        auto folder = map();
+        (*folder)["folder_id"] = Value(id);
+        (*folder)["name"] = Value(text(options_.max_string));
+        (*folder)["type_default"] = Value(between(-1, 56));
+        (*folder)["version"] = Value(between(1, 10000));
+        (*folder)["items"] = Value(std::move(items));
+        (*folder)["categories"] = Value(std::move(categories));
+        return Value(std::move(folder));
+    }
+
+    Value object_properties() {
+        auto objects = array();
+        std::size_t count = 1 + below(std::max<std::size_t>(1, options_.scale));
+        for (std::size_t i = 0; i < count; ++i) {
+            auto textures = array();
+            for (std::size_t n = 1 + below(8); n > 0; --n) textures->push_back(Value(uuid()));
+            auto object = map();
+            (*object)["ObjectID"] = Value(uuid());
+            (*object)["OwnerID"] = Value(uuid());
+            (*object)["GroupID"] = Value(chance(70) ? LLUUID() : uuid());
+            (*object)["Name"] = Value(text(options_.max_string));
+            (*object)["Description"] = Value(text(options_.max_string));
+            (*object)["CreationDate"] = Value(date());
+            (*object)["Position"] = vector(3);
+            (*object)["Scale"] = vector(3);
+            (*object)["Rotation"] = vector(4);
+            (*object)["TextureIDs"] = Value(std::move(textures));
+            (*object)["Flags"] = Value(between(0, INT32_MAX));
+            (*object)["SalePrice"] = Value(between(0, 5000));
+            (*object)["TouchName"] = Value(chance(80) ? std::string() : text(16));
+            objects->push_back(Value(std::move(object)));
+        }
+        auto doc = map();
+        (*doc)["ObjectData"] = Value(std::move(objects));
+        return Value(std::move(doc));
+    }
+
+    Value appearance() {
+        auto textures = array();
+        for (int i = 0; i < 21; ++i) textures->push_back(Value(uuid()));
+        auto layers = array();
+        for (int i = 0; i < 12; ++i) layers->push_back(Value(between(0, 255)));
+        auto attachments = array();
+        for (std::size_t n = below(options_.scale + 1); n > 0; --n) {
+            auto attachment = map();
+            (*attachment)["attachment_point"] = Value(between(1, 55));
+            (*attachment)["item_id"] = Value(uuid());
+            (*attachment)["asset_id"] = Value(uuid());
+            attachments->push_back(Value(std::move(attachment)));
+        }
+        auto doc = map();
+        (*doc)["agent_id"] = Value(uuid());
+        (*doc)["cof_version"] = Value(between(1, 100000));
+        (*doc)["hover_height"] = Value(real());
+        (*doc)["visual_params"] = Value(blob(253));
+        (*doc)["texture_hashes"] = Value(blob(21 * 16));
+        (*doc)["textures"] = Value(std::move(textures));
+        (*doc)["layers"] = Value(std::move(layers));
+        (*doc)["attachments"] = Value(std::move(attachments));
+        return Value(std::move(doc));
+    }
+
+    Value config(std::size_t depth) {
+        // Containers thin out with depth so trees stay finite
+        const std::size_t width = std::max<std::size_t>(1, options_.scale >> std::min<std::size_t>(depth, 8));
+        if (depth + 1 < options_.max_depth && chance(depth == 0 ? 100 : 60)) {
+            if (chance(70)) {
+                auto m = map();
+                for (std::size_t n = 1 + below(width); n > 0; --n) {
+                    std::string k = key();
+                    (*m)[k] = config(depth + 1);
+                }
+                return Value(std::move(m));
+            }
+            auto a = array();
+            for (std::size_t n = below(width + 1); n > 0; --n) a->push_back(config(depth + 1));
+            return Value(std::move(a));
+        }
+        return scalar();
+    }
+
+    CorpusOptions options_;
+    std::uint64_t state_;
+};
+
+// Serializes each of `docs` with format(), ready to feed to parse()
+inline std::vector<std::string> format_corpus(const std::vector<Value>& docs, Format f) {
+    std::vector<std::string> out;
+    out.reserve(docs.size());
+    for (const Value& doc : docs) out.push_back(format(doc, f));
+    return out;
+}
+
+} // namespace llsd_modern
@@ -0,0 +1,1035 @@
+/**
+ * @file llsd_modern_parallel.hpp
+ * @brief Multi-threaded batch conversion on top of llsd_modern.hpp.
+ *
+ * Copyright (c) 2025 humbletim
+ *
+ * This library is licensed under the MIT License.
+ */
+#pragma once
+
+#include "llsd_modern.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <fstream>
+#include <future>
+#include <mutex>
+#include <queue>
+#include <shared_mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace llsd_modern {
+
+// Fixed-size pool of worker threads draining a shared FIFO of tasks
+class ThreadPool {
+public:
+    explicit ThreadPool(std::size_t threads = std::thread::hardware_concurrency()) {
+        if (threads == 0) threads = 1;
+        workers_.reserve(threads);
+        for (std::size_t i = 0; i < threads; ++i) {
+            workers_.emplace_back([this] { run(); });
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        cv_.notify_all();
+        for (auto& worker : workers_) worker.join();
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    std::size_t size() const { return workers_.size(); }
+
+    // Queues `fn` and returns a future for its result (or exception)
+    template<typename Fn>
+    auto submit(Fn&& fn) -> std::future<std::invoke_result_t<std::decay_t<Fn>>> {
+        using R = std::invoke_result_t<std::decay_t<Fn>>;
+        auto task = std::make_shared<std::packaged_task<R()>>(std::forward<Fn>(fn));
+        auto future = task->get_future();
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            tasks_.emplace_back([task] { (*task)(); });
+        }
+        cv_.notify_one();
+        return future;
+    }
+
+private:
+    void run() {
+        for (;;) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                cv_.wait(lock, [this] { return stopping_ || !tasks_.empty(); });
+                if (tasks_.empty()) return;
+                task = std::move(tasks_.front());
+                tasks_.pop_front();
+            }
+            task();
+        }
+    }
+
+    std::vector<std::thread> workers_;
+    std::deque<std::function<void()>> tasks_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool stopping_ = false;
+};
+
+// Read-only view of a whole file, memory-mapped where the platform allows
+// and read into memory otherwise.
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path) {
+#if defined(__unix__) || defined(__APPLE__)
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) throw std::runtime_error("Cannot open " + path);
+        struct stat st;
+        if (::fstat(fd, &st) != 0) {
+            ::close(fd);
+            throw std::runtime_error("Cannot stat " + path);
+        }
+        size_ = static_cast<std::size_t>(st.st_size);
+        if (size_ > 0) {
+            void* p = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+            ::close(fd);
+            if (p == MAP_FAILED) throw std::runtime_error("Cannot map " + path);
+            ::madvise(p, size_, MADV_SEQUENTIAL);
+            data_ = static_cast<const char*>(p);
+        } else {
+            ::close(fd);
+        }
+#else
+        std::ifstream in(path, std::ios::binary);
+        if (!in) throw std::runtime_error("Cannot open " + path);
+        fallback_.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        data_ = fallback_.data();
+        size_ = fallback_.size();
+#endif
+    }
+
+    ~MappedFile() {
+#if defined(__unix__) || defined(__APPLE__)
+        if (data_) ::munmap(const_cast<char*>(data_), size_);
+#endif
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    std::string_view view() const { return std::string_view(data_, size_); }
+
+private:
+    const char* data_ = nullptr;
+    std::size_t size_ = 0;
+#if !(defined(__unix__) || defined(__APPLE__))
+    std::string fallback_;
+#endif
+};
+
+// Map of Values that many threads can read and update at once. Keys are
+// spread by hash over independently locked shards, so writers only contend
+// when they touch the same shard, and readers of a shard share its lock.
+class ConcurrentMap {
+public:
+    explicit ConcurrentMap(std::size_t shards = 64)
+        : shards_(new Shard[shards ? shards : 1]), shard_count_(shards ? shards : 1) {}
+
+    ConcurrentMap(const ConcurrentMap&) = delete;
+    ConcurrentMap& operator=(const ConcurrentMap&) = delete;
+
+    // A copy of the entry `key`, or nothing if it is absent
+    std::optional<Value> get(const std::string& key) const {
+        const Shard& shard = shard_for(key);
+        std::shared_lock<std::shared_mutex> lock(shard.mutex);
+        auto it = shard.entries.find(key);
+        if (it == shard.entries.end()) return std::nullopt;
+        return it->second;
+    }
+
+    // Calls `fn(const Value&)` on the entry `key` under a shared lock, without
+    // copying it; returns whether the entry exists
+    template<typename Fn>
+    bool read(const std::string& key, Fn&& fn) const {
+        const Shard& shard = shard_for(key);
+        std::shared_lock<std::shared_mutex> lock(shard.mutex);
+        auto it = shard.entries.find(key);
+        if (it == shard.entries.end()) return false;
+        fn(it->second);
+        return true;
+    }
+
+    bool contains(const std::string& key) const {
+        const Shard& shard = shard_for(key);
+        std::shared_lock<std::shared_mutex> lock(shard.mutex);
+        return shard.entries.count(key) != 0;
+    }
+
+    void set(const std::string& key, Value v) {
+        Shard& shard = shard_for(key);
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        shard.entries.insert_or_assign(key, std::move(v));
+    }
+
+    // Calls `fn(Value&)` on the entry `key` under its shard's exclusive lock,
+    // creating an Undef entry first if needed, and returns what `fn` returns.
+    // This is the way to do read-modify-write (counters, appends) atomically;
+    // `fn` must not touch this map.
+    template<typename Fn>
+    decltype(auto) update(const std::string& key, Fn&& fn) {
+        Shard& shard = shard_for(key);
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        return fn(shard.entries[key]);
+    }
+
+    bool erase(const std::string& key) {
+        Shard& shard = shard_for(key);
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        return shard.entries.erase(key) != 0;
+    }
+
+    std::size_t size() const {
+        std::size_t total = 0;
+        for (std::size_t i = 0; i < shard_count_; ++i) {
+            std::shared_lock<std::shared_mutex> lock(shards_[i].mutex);
+            total += shards_[i].entries.size();
+        }
+        return total;
+    }
+
+    // Calls `fn(const std::string&, const Value&)` for every entry, holding
+    // one shard's shared lock at a time
+    template<typename Fn>
+    void for_each(Fn&& fn) const {
+        for (std::size_t i = 0; i < shard_count_; ++i) {
+            std::shared_lock<std::shared_mutex> lock(shards_[i].mutex);
+            for (const auto& [key, value] : shards_[i].entries) fn(key, value);
+        }
+    }
+
+    // Copies every entry into an ordinary Map (ready for format_binary and
+    // friends). Shards are copied one at a time under a shared lock, so
+    // writers only wait while their own shard is being copied. Each shard is
+    // internally consistent, but the result is not a single point in time
+    // across shards.
+    Map snapshot() const {
+        Map map;
+        for_each([&](const std::string& key, const Value& value) { map.try_emplace(key, value); });
+        return map;
+    }
+
+private:
+    // Padded to a cache line so neighbouring shard locks don't false-share
+    struct alignas(64) Shard {
+        mutable std::shared_mutex mutex;
+        std::unordered_map<std::string, Value> entries;
+    };
+
+    Shard& shard_for(const std::string& key) const {
+        return shards_[std::hash<std::string>{}(key) % shard_count_];
+    }
+
+    std::unique_ptr<Shard[]> shards_;
+    std::size_t shard_count_;
+};
+
+namespace detail {
+
+// Helper to round a ring capacity up to a power of two (at least 2)
+inline std::size_t ring_size(std::size_t capacity) {
+    std::size_t size = 2;
+    while (size < capacity) size <<= 1;
+    return size;
+}
+
+} // namespace detail
+
+// Bounded single-producer/single-consumer queue. Each side owns one index
+// and keeps a cached copy of the other's, so an uncontended push or pop
+// touches no shared cache line. try_push moves from `v` only on success.
+template<typename T>
+class SpscRing {
+public:
+    explicit SpscRing(std::size_t capacity) : mask_(detail::ring_size(capacity) - 1), slots_(new T[mask_ + 1]) {}
+
+    bool try_push(T&& v) {
+        std::size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_cache_ > mask_) {
+            head_cache_ = head_.load(std::memory_order_acquire);
+            if (tail - head_cache_ > mask_) return false;
+        }
+        slots_[tail & mask_] = std::move(v);
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool try_pop(T& out) {
+        std::size_t head = head_.load(std::memory_order_relaxed);
+        if (head == tail_cache_) {
+            tail_cache_ = tail_.load(std::memory_order_acquire);
+            if (head == tail_cache_) return false;
+        }
+        out = std::move(slots_[head & mask_]);
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    const std::size_t mask_;
+    std::unique_ptr<T[]> slots_;
+    alignas(64) std::atomic<std::size_t> head_{0};
+    std::size_t tail_cache_ = 0;
+    alignas(64) std::atomic<std::size_t> tail_{0};
+    std::size_t head_cache_ = 0;
+};
+
+// Bounded multi-producer/multi-consumer queue (Vyukov's design): every slot
+// carries a sequence number telling producers and consumers whose turn it
+// is, so each side claims a slot with one CAS on its own index.
+template<typename T>
+class MpmcRing {
+public:
+    explicit MpmcRing(std::size_t capacity) : mask_(detail::ring_size(capacity) - 1), cells_(new Cell[mask_ + 1]) {
+        for (std::size_t i = 0; i <= mask_; ++i) cells_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    bool try_push(T&& v) {
+        std::size_t pos = tail_.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& cell = cells_[pos & mask_];
+            std::size_t seq = cell.sequence.load(std::memory_order_acquire);
+            auto dif = static_cast<std::ptrdiff_t>(seq - pos);
+            if (dif == 0) {
+                if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    cell.value = std::move(v);
+                    cell.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (dif < 0) {
+                return false;
+            } else {
+                pos = tail_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool try_pop(T& out) {
+        std::size_t pos = head_.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& cell = cells_[pos & mask_];
+            std::size_t seq = cell.sequence.load(std::memory_order_acquire);
+            auto dif = static_cast<std::ptrdiff_t>(seq - (pos + 1));
+            if (dif == 0) {
+                if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    out = std::move(cell.value);
+                    cell.sequence.store(pos + mask_ + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (dif < 0) {
+                return false;
+            } else {
+                pos = head_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+private:
+    struct Cell {
+        std::atomic<std::size_t> sequence;
+        T value;
+    };
+
+    const std::size_t mask_;
+    std::unique_ptr<Cell[]> cells_;
+    alignas(64) std::atomic<std::size_t> head_{0};
+    alignas(64) std::atomic<std::size_t> tail_{0};
+};
+
+// Tuning for run_binary_pipeline
+struct PipelineOptions {
+    std::size_t workers = 1;    // threads in the transform stage
+    std::size_t batch = 64;     // documents handed over per hop
+    std::size_t capacity = 64;  // batches buffered per hop before upstream waits
+    bool pin_threads = false;   // pin each pipeline thread to its own core (Linux only)
+};
+
+// Tuning for the parallel tree algorithms (parallel_copy and friends)
+struct ParallelTreeOptions {
+    std::size_t min_nodes = 4096;       // trees with fewer nodes are walked sequentially
+    std::size_t leaves_per_worker = 16; // subtrees to split into per thread, for balance
+};
+
+// Whether batch results are delivered in input order on the calling thread,
+// or on worker threads as soon as each one is ready.
+enum class Ordering { Ordered, Unordered };
+
+namespace detail {
+
+// Helper to split NDJSON text into its non-blank lines
+inline std::vector<std::string_view> split_ndjson(std::string_view text) {
+    std::vector<std::string_view> lines;
+    std::size_t pos = 0;
+    while (pos < text.size()) {
+        std::size_t nl = text.find('\n', pos);
+        if (nl == std::string_view::npos) nl = text.size();
+        std::string_view line = text.substr(pos, nl - pos);
+        if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+        if (line.find_first_not_of(" \t") != std::string_view::npos) lines.push_back(line);
+        pos = nl + 1;
+    }
+    return lines;
+}
+
+// Runs `convert(std::size_t sequence)` for every sequence in [0, count) on
+// `pool`, in blocks sized to keep all workers busy, and hands each result to
+// `emit(sequence, R&&)`. At most a few blocks per worker are in flight, which
+// bounds memory for ordered delivery. The first exception thrown by
+// `convert` is rethrown once all outstanding work has drained.
+template<typename Convert, typename Emit>
+void run_batch(std::size_t count, Convert&& convert, Emit&& emit, ThreadPool& pool, Ordering order) {
+    using R = std::invoke_result_t<Convert&, std::size_t>;
+    const std::size_t block = std::max<std::size_t>(1, std::min<std::size_t>(256, count / (pool.size() * 8)));
+    const std::size_t max_in_flight = pool.size() * 4;
+
+    std::mutex emit_mutex;
+    std::deque<std::future<std::vector<std::pair<std::size_t, R>>>> in_flight;
+    std::exception_ptr error;
+
+    auto drain_one = [&] {
+        try {
+            auto results = in_flight.front().get();
+            if (order == Ordering::Ordered && !error) {
+                for (auto& [seq, value] : results) emit(seq, std::move(value));
+            }
+        } catch (...) {
+            if (!error) error = std::current_exception();
+        }
+        in_flight.pop_front();
+    };
+
+    for (std::size_t first = 0; first < count; first += block) {
+        std::size_t last = std::min(count, first + block);
+        in_flight.push_back(pool.submit([&, first, last] {
+            std::vector<std::pair<std::size_t, R>> results;
+            results.reserve(last - first);
+            for (std::size_t seq = first; seq < last; ++seq) {
+                results.emplace_back(seq, convert(seq));
+            }
+            if (order == Ordering::Unordered) {
+                std::lock_guard<std::mutex> lock(emit_mutex);
+                for (auto& [seq, value] : results) emit(seq, std::move(value));
+                results.clear();
+            }
+            return results;
+        }));
+        if (in_flight.size() >= max_in_flight) drain_one();
+        if (error) break;
+    }
+    while (!in_flight.empty()) drain_one();
+    if (error) std::rethrow_exception(error);
+}
+
+template<typename Fn>
+auto with_record_context(std::size_t seq, Fn&& fn) -> decltype(fn()) {
+    try {
+        return fn();
+    } catch (const std::exception& e) {
+        throw std::runtime_error("NDJSON record " + std::to_string(seq) + ": " + e.what());
+    }
+}
+
+// Runs `fn(worker, index)` for every index in [0, count) on the calling
+// thread plus every worker of `pool`, where `worker` is a dense id below
+// pool.size() + 1 for indexing per-worker scratch state. Each worker starts
+// with an equal slice of the range and, once it runs dry, steals the back
+// half of the fullest remaining slice (or its last item), so uneven items
+// don't leave cores idle. A slice is a [begin, end) pair packed into one
+// atomic word: the owner takes items from the front and thieves split off the
+// back, both by CAS. Workers the pool has not started by the time the calling
+// thread runs dry are cancelled rather than waited for, so the calling thread
+// finishes alone if it must, e.g. when called from a task on a busy `pool`.
+// `fn` must not throw.
+template<typename Fn>
+void steal_each(std::size_t count, ThreadPool& pool, Fn&& fn) {
+    if (count == 0) return;
+    if (count > 0xffffffffu) throw std::runtime_error("Batch too large");
+    const std::size_t workers = std::min(count, pool.size() + 1);
+    auto pack = [](std::uint64_t begin, std::uint64_t end) { return (begin << 32) | end; };
+    struct alignas(64) Slice { std::atomic<std::uint64_t> range; };
+    std::unique_ptr<Slice[]> slices(new Slice[workers]);
+    for (std::size_t w = 0; w < workers; ++w) {
+        slices[w].range = pack(count * w / workers, count * (w + 1) / workers);
+    }
+
+    auto run = [&](std::size_t w) {
+        std::atomic<std::uint64_t>& mine = slices[w].range;
+        for (;;) {
+            std::uint64_t r = mine.load();
+            std::uint64_t begin = r >> 32, end = r & 0xffffffffu;
+            if (begin < end) {
+                if (mine.compare_exchange_weak(r, pack(begin + 1, end))) fn(w, static_cast<std::size_t>(begin));
+                continue;
+            }
+            // Out of work: split the largest slice left, take the last item
+            // of one, or finish
+            std::size_t victim = workers;
+            std::uint64_t most = 0;
+            for (std::size_t v = 0; v < workers; ++v) {
+                std::uint64_t vr = slices[v].range.load();
+                std::uint64_t left = (vr & 0xffffffffu) - std::min(vr >> 32, vr & 0xffffffffu);
+                if (left > most) {
+                    most = left;
+                    victim = v;
+                }
+            }
+            if (victim == workers) return;
+            std::uint64_t vr = slices[victim].range.load();
+            std::uint64_t vbegin = vr >> 32, vend = vr & 0xffffffffu;
+            std::uint64_t left = vend - std::min(vbegin, vend);
+            if (left == 1 && slices[victim].range.compare_exchange_strong(vr, pack(vbegin + 1, vend))) {
+                fn(w, static_cast<std::size_t>(vbegin));
+            }
+            if (left < 2) continue;
+            std::uint64_t mid = vbegin + (vend - vbegin) / 2;
+            if (slices[victim].range.compare_exchange_strong(vr, pack(vbegin, mid))) {
+                // Only this worker writes its own empty slice, so a plain
+                // store is safe; thieves see it as up for grabs afterwards
+                mine.store(pack(mid, vend));
+            }
+        }
+    };
+
+    // A helper runs only if it claims its flag before the calling thread
+    // cancels it; the flags are shared so a helper starting after this call
+    // has returned still has something to check
+    enum : std::uint8_t { kQueued, kRunning, kCancelled };
+    std::shared_ptr<std::atomic<std::uint8_t>[]> states(new std::atomic<std::uint8_t>[workers]);
+    for (std::size_t w = 0; w < workers; ++w) states[w].store(kQueued);
+    std::vector<std::future<void>> helpers;
+    helpers.reserve(workers - 1);
+    for (std::size_t w = 1; w < workers; ++w) {
+        helpers.push_back(pool.submit([&run, w, states] {
+            std::uint8_t queued = kQueued;
+            if (states[w].compare_exchange_strong(queued, kRunning)) run(w);
+        }));
+    }
+    run(0);
+    for (std::size_t w = 1; w < workers; ++w) {
+        std::uint8_t queued = kQueued;
+        if (!states[w].compare_exchange_strong(queued, kCancelled)) helpers[w - 1].get();
+    }
+}
+
+// Spins briefly, then yields, while a ring is full or empty
+class Backoff {
+public:
+    void pause() {
+        if (spins_ < 64) {
+            ++spins_;
+        } else {
+            std::this_thread::yield();
+        }
+    }
+    void reset() { spins_ = 0; }
+
+private:
+    int spins_ = 0;
+};
+
+// Best-effort pinning of the calling thread to one core
+inline void pin_current_thread(std::size_t index) {
+#if defined(__linux__)
+    unsigned cores = std::thread::hardware_concurrency();
+    if (cores == 0) return;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(index % cores, &set);
+    pthread_setaffinity_np(pthread_self(), sizeof set, &set);
+#else
+    (void)index;
+#endif
+}
+
+// A run of consecutive documents moving between pipeline stages; `sequence`
+// numbers batches in input order
+struct PipelineBatch {
+    std::size_t sequence = 0;
+    std::vector<Value> values;
+};
+
+// The body of run_binary_pipeline, with `Ring` chosen by the number of
+// transform threads
+template<template<typename> class Ring, typename Transform>
+void run_pipeline(std::istream& in, std::ostream& out, Transform& transform, const PipelineOptions& options) {
+    const std::size_t workers = std::max<std::size_t>(1, options.workers);
+    const std::size_t batch_size = std::max<std::size_t>(1, options.batch);
+    Ring<PipelineBatch> decoded(options.capacity), transformed(options.capacity);
+    std::atomic<bool> decoding{true}, failed{false};
+    std::atomic<std::size_t> transforming{workers};
+    std::mutex error_mutex;
+    std::exception_ptr error;
+    auto fail = [&] {
+        std::lock_guard<std::mutex> lock(error_mutex);
+        if (!error) error = std::current_exception();
+        failed = true;
+    };
+    // Pushes with backpressure; false if the pipeline failed meanwhile
+    auto push = [&](auto& ring, PipelineBatch&& batch) {
+        Backoff backoff;
+        while (!ring.try_push(std::move(batch))) {
+            if (failed) return false;
+            backoff.pause();
+        }
+        return true;
+    };
+    // Pops until a batch arrives or `upstream` has finished and drained
+    auto pop = [&](auto& ring, PipelineBatch& batch, auto upstream_done) {
+        Backoff backoff;
+        for (;;) {
+            if (ring.try_pop(batch)) return true;
+            if (failed) return false;
+            if (upstream_done()) return ring.try_pop(batch);
+            backoff.pause();
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(workers + 1);
+    threads.emplace_back([&] {
+        if (options.pin_threads) pin_current_thread(0);
+        try {
+            PipelineBatch batch;
+            std::size_t sequence = 0;
+            while (!failed && in.peek() != std::char_traits<char>::eof()) {
+                if (batch.values.empty()) batch.values.reserve(batch_size);
+                batch.values.push_back(parse_binary(in));
+                if (batch.values.size() == batch_size) {
+                    batch.sequence = sequence++;
+                    if (!push(decoded, std::move(batch))) break;
+                    batch = PipelineBatch();
+                }
+            }
+            if (!batch.values.empty()) {
+                batch.sequence = sequence;
+                push(decoded, std::move(batch));
+            }
+        } catch (...) {
+            fail();
+        }
+        decoding.store(false, std::memory_order_release);
+    });
+    for (std::size_t w = 0; w < workers; ++w) {
+        threads.emplace_back([&, w] {
+            if (options.pin_threads) pin_current_thread(1 + w);
+            try {
+                PipelineBatch batch;
+                while (pop(decoded, batch, [&] { return !decoding.load(std::memory_order_acquire); })) {
+                    for (Value& v : batch.values) transform(v);
+                    if (!push(transformed, std::move(batch))) break;
+                }
+            } catch (...) {
+                fail();
+            }
+            transforming.fetch_sub(1, std::memory_order_release);
+        });
+    }
+
+    // The calling thread encodes, restoring input order across workers
+    try {
+        std::map<std::size_t, PipelineBatch> pending;
+        std::size_t next = 0;
+        PipelineBatch batch;
+        while (pop(transformed, batch, [&] { return transforming.load(std::memory_order_acquire) == 0; })) {
+            pending.emplace(batch.sequence, std::move(batch));
+            for (auto it = pending.begin(); it != pending.end() && it->first == next; it = pending.erase(it), ++next) {
+                for (const Value& v : it->second.values) format_binary(out, v);
+            }
+        }
+    } catch (...) {
+        fail();
+    }
+    for (auto& thread : threads) thread.join();
+    if (error) std::rethrow_exception(error);
+}
+
+// Calls `fn(const std::string* key, const Value& child)` for each element of
+// an array (key is null) or map, in iteration order
+template<typename Fn>
+void for_each_child(const Value& v, Fn&& fn) {
+    if (auto array = std::get_if<std::unique_ptr<Array>>(&v.data); array && *array) {
+        for (const Value& child : **array) fn(nullptr, child);
+    } else if (auto map = std::get_if<std::unique_ptr<Map>>(&v.data); map && *map) {
+        for (const auto& [key, child] : **map) fn(&key, child);
+    }
+}
+
+// Number of children a tree algorithm can hand out separately: the elements
+// of an array or map
+inline std::size_t fanout(const Value& v) {
+    if (auto array = std::get_if<std::unique_ptr<Array>>(&v.data); array && *array) return (*array)->size();
+    if (auto map = std::get_if<std::unique_ptr<Map>>(&v.data); map && *map) return (*map)->size();
+    return 0;
+}
+
+// Counts the nodes of `v`, stopping once `limit` is reached
+inline std::size_t count_nodes(const Value& v, std::size_t limit) {
+    std::size_t count = 1;
+    for_each_child(v, [&](const std::string*, const Value& child) {
+        if (count < limit) count += count_nodes(child, limit - count);
+    });
+    return count;
+}
+
+// How the parallel tree algorithms divide a tree: the containers in `split`
+// are opened up and their children handled separately; every other node
+// reached that way is a leaf, processed whole by one worker.
+struct TreePlan {
+    std::unordered_set<const Value*> split;
+    std::vector<const Value*> leaves; // in depth-first order
+};
+
+// Plans the division of `root` for `workers` threads, splitting the widest
+// containers first until there are enough leaves to balance the load.
+// Returns false when the tree is too small to be worth it.
+inline bool plan_tree(const Value& root, std::size_t workers, const ParallelTreeOptions& options, TreePlan& plan) {
+    if (workers < 2 || count_nodes(root, options.min_nodes) < options.min_nodes) return false;
+    const std::size_t target = workers * std::max<std::size_t>(1, options.leaves_per_worker);
+    std::priority_queue<std::pair<std::size_t, const Value*>> widest;
+    // Single-child containers are opened too, so a wrapper like
+    // {"objects":[...]} doesn't hide the array inside
+    if (fanout(root) > 0) widest.emplace(fanout(root), &root);
+    std::size_t leaves = 1;
+    while (!widest.empty() && leaves < target) {
+        auto [width, node] = widest.top();
+        widest.pop();
+        plan.split.insert(node);
+        leaves += width - 1;
+        for_each_child(*node, [&](const std::string*, const Value& child) {
+            if (std::size_t w = fanout(child); w > 0) widest.emplace(w, &child);
+        });
+    }
+    if (plan.split.empty()) return false;
+    auto collect = [&](auto& self, const Value& v) -> void {
+        if (!plan.split.count(&v)) {
+            plan.leaves.push_back(&v);
+            return;
+        }
+        for_each_child(v, [&](const std::string*, const Value& child) { self(self, child); });
+    };
+    collect(collect, root);
+    return true;
+}
+
+// Runs `fn(std::size_t i)` for each i in [0, count) with steal_each,
+// rethrowing the first exception once all items have run
+template<typename Fn>
+void steal_each_checked(std::size_t count, ThreadPool& pool, Fn&& fn) {
+    std::mutex error_mutex;
+    std::exception_ptr error;
+    steal_each(count, pool, [&](std::size_t, std::size_t i) {
+        try {
+            fn(i);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(error_mutex);
+            if (!error) error = std::current_exception();
+        }
+    });
+    if (error) std::rethrow_exception(error);
+}
+
+// Evaluates `leaf(const Value&) -> R` on every leaf of `plan` in parallel,
+// then folds the results back up the split containers on the calling thread
+// with `join(const Value& container, std::vector<R>& children)`, children
+// being in iteration order
+template<typename R, typename Leaf, typename Join>
+R reduce_tree(const Value& root, const TreePlan& plan, ThreadPool& pool, Leaf&& leaf, Join&& join) {
+    std::vector<R> results(plan.leaves.size());
+    steal_each_checked(plan.leaves.size(), pool, [&](std::size_t i) { results[i] = leaf(*plan.leaves[i]); });
+    std::size_t next = 0;
+    auto fold = [&](auto& self, const Value& v) -> R {
+        if (!plan.split.count(&v)) return std::move(results[next++]);
+        std::vector<R> children;
+        children.reserve(fanout(v));
+        for_each_child(v, [&](const std::string*, const Value& child) { children.push_back(self(self, child)); });
+        return join(v, children);
+    };
+    return fold(fold, root);
+}
+
+} // namespace detail
+
+// Parses every non-blank line of `ndjson` as a JSON document on `pool` and
+// calls `on_value(std::size_t sequence, Value&& value)` for each, where
+// sequence is the 0-based record index. With Ordering::Ordered the callback
+// runs on the calling thread in record order; with Ordering::Unordered it
+// runs on worker threads (serialized by an internal mutex) as records
+// complete. Throws the first parse error, tagged with its record index.
+template<typename Fn>
+void parse_ndjson(std::string_view ndjson, Fn&& on_value, ThreadPool& pool, Ordering order = Ordering::Ordered) {
+    auto lines = detail::split_ndjson(ndjson);
+    detail::run_batch(lines.size(),
+        [&](std::size_t seq) {
+            return detail::with_record_context(seq, [&] { return parse_json(lines[seq]); });
+        },
+        on_value, pool, order);
+}
+
+// Converts NDJSON to a sequence of concatenated binary LLSD documents, one
+// per non-blank line, in line order. Each line is transcoded directly (see
+// json_to_binary), so map keys keep their input order.
+inline void ndjson_to_binary(std::string_view ndjson, std::ostream& out, ThreadPool& pool) {
+    auto lines = detail::split_ndjson(ndjson);
+    detail::run_batch(lines.size(),
+        [&](std::size_t seq) {
+            return detail::with_record_context(seq, [&] { return json_to_binary(lines[seq]); });
+        },
+        [&](std::size_t, std::string&& doc) { out.write(doc.data(), doc.size()); },
+        pool, Ordering::Ordered);
+}
+
+// Converts a stream of concatenated binary LLSD documents to NDJSON. Documents
+// are decoded on the calling thread (binary has no record delimiters to split
+// on) and formatted to JSON on `pool`, a batch at a time.
+inline void binary_to_ndjson(std::istream& in, std::ostream& out, ThreadPool& pool) {
+    const std::size_t batch_size = pool.size() * 256;
+    std::vector<Value> batch;
+    batch.reserve(batch_size);
+    auto flush_batch = [&] {
+        detail::run_batch(batch.size(),
+            [&](std::size_t seq) { return format_json(batch[seq]); },
+            [&](std::size_t, std::string&& line) {
+                out.write(line.data(), line.size());
+                out.put('\n');
+            },
+            pool, Ordering::Ordered);
+        batch.clear();
+    };
+    while (in.peek() != std::char_traits<char>::eof()) {
+        batch.push_back(parse_binary(in));
+        if (batch.size() == batch_size) flush_batch();
+    }
+    flush_batch();
+}
+
+// Outcome of converting one document in a batch
+struct ConversionResult {
+    std::string output; // the converted document, when ok
+    std::string error;  // what the conversion threw, otherwise
+    bool ok = false;
+};
+
+// Converts each of `count` independent documents (in any format parse()
+// detects) to `to`, as format() writes it, on the calling thread and `pool`.
+// Results come back in input order, and a document that fails to parse only
+// fails its own entry. Each document is formatted straight into its result,
+// sized up front from the input, so small messages cost about one output
+// allocation each and no copy.
+inline std::vector<ConversionResult> convert_batch(const std::string_view* inputs, std::size_t count,
+                                                   Format to, ThreadPool& pool) {
+    std::vector<ConversionResult> results(count);
+    detail::steal_each(count, pool, [&](std::size_t, std::size_t i) {
+        ConversionResult& result = results[i];
+        try {
+            Value v = parse(inputs[i]);
+            result.output.reserve(inputs[i].size() + 64);
+            format(result.output, v, to);
+            result.ok = true;
+        } catch (const std::exception& e) {
+            result.error = e.what();
+        } catch (...) {
+            result.error = "Unknown error";
+        }
+    });
+    return results;
+}
+
+inline std::vector<ConversionResult> convert_batch(const std::vector<std::string_view>& inputs, Format to,
+                                                   ThreadPool& pool) {
+    return convert_batch(inputs.data(), inputs.size(), to, pool);
+}
+
+// Streams concatenated binary LLSD documents from `in` through three stages
+// (decode, `transform(Value&)`, encode) and writes the results to `out` in
+// input order. Decoding runs on one thread, transforming on
+// options.workers threads and encoding on the calling thread. The stages
+// hand over batches of documents through lock-free rings that hold at most
+// options.capacity batches, so a slow stage holds the earlier ones back
+// rather than letting memory grow. The first exception thrown by any stage
+// stops the pipeline and is rethrown here.
+template<typename Transform>
+void run_binary_pipeline(std::istream& in, std::ostream& out, Transform&& transform,
+                         const PipelineOptions& options = PipelineOptions()) {
+    if (options.workers <= 1) {
+        detail::run_pipeline<SpscRing>(in, out, transform, options);
+    } else {
+        detail::run_pipeline<MpmcRing>(in, out, transform, options);
+    }
+}
+
+// Parallel versions of the recursive whole-tree operations. Each splits the
+// tree into subtrees (see ParallelTreeOptions), processes those on the
+// calling thread and `pool` with work stealing, and joins the results, which
+// are identical to the sequential operation's. Trees below
+// options.min_nodes are handled sequentially.
+
+// Same as Value(v)
+inline Value parallel_copy(const Value& v, ThreadPool& pool, const ParallelTreeOptions& options = {}) {
+    detail::TreePlan plan;
+    if (!detail::plan_tree(v, pool.size() + 1, options, plan)) return Value(v);
+    // Copy the split containers, leaving Undef where each leaf goes...
+    auto skeleton = [&](auto& self, const Value& src) -> Value {
+        if (!plan.split.count(&src)) return Value();
+        if (std::holds_alternative<std::unique_ptr<Array>>(src.data)) {
+            auto array = std::make_unique<Array>();
+            array->reserve(detail::fanout(src));
+            detail::for_each_child(src, [&](const std::string*, const Value& child) { array->push_back(self(self, child)); });
+            return Value(std::move(array));
+        }
+        auto map = std::make_unique<Map>();
+        detail::for_each_child(src, [&](const std::string* key, const Value& child) { map->try_emplace(*key, self(self, child)); });
+        return Value(std::move(map));
+    };
+    Value copy = skeleton(skeleton, v);
+    // ...then find those places, in the same order as plan.leaves
+    std::vector<Value*> targets;
+    targets.reserve(plan.leaves.size());
+    auto locate = [&](auto& self, const Value& src, Value& dst) -> void {
+        if (!plan.split.count(&src)) {
+            targets.push_back(&dst);
+            return;
+        }
+        if (auto array = std::get_if<std::unique_ptr<Array>>(&dst.data)) {
+            auto it = (*array)->begin();
+            detail::for_each_child(src, [&](const std::string*, const Value& child) { self(self, child, *it++); });
+        } else {
+            auto it = std::get<std::unique_ptr<Map>>(dst.data)->begin();
+            detail::for_each_child(src, [&](const std::string*, const Value& child) { self(self, child, (it++)->second); });
+        }
+    };
+    locate(locate, v, copy);
+    detail::steal_each_checked(plan.leaves.size(), pool, [&](std::size_t i) { *targets[i] = *plan.leaves[i]; });
+    return copy;
+}
+
+// Same as a == b
+inline bool parallel_equal(const Value& a, const Value& b, ThreadPool& pool, const ParallelTreeOptions& options = {}) {
+    detail::TreePlan plan;
+    if (!detail::plan_tree(a, pool.size() + 1, options, plan)) return a == b;
+    // Match up the split containers of `a` with `b`, comparing their shapes
+    // and pairing each leaf of `a` with its counterpart
+    std::vector<std::pair<const Value*, const Value*>> pairs;
+    pairs.reserve(plan.leaves.size());
+    auto pair_up = [&](auto& self, const Value& x, const Value& y) -> bool {
+        if (!plan.split.count(&x)) {
+            pairs.emplace_back(&x, &y);
+            return true;
+        }
+        if (x.data.index() != y.data.index()) return false;
+        if (auto array = std::get_if<std::unique_ptr<Array>>(&y.data)) {
+            if (!*array || (*array)->size() != detail::fanout(x)) return false;
+            const Array& values = **array;
+            std::size_t i = 0;
+            bool same = true;
+            detail::for_each_child(x, [&](const std::string*, const Value& child) {
+                same = same && self(self, child, values[i++]);
+            });
+            return same;
+        }
+        const auto& map = std::get<std::unique_ptr<Map>>(y.data);
+        if (!map || map->size() != detail::fanout(x)) return false;
+        auto it = map->begin();
+        bool same = true;
+        detail::for_each_child(x, [&](const std::string* key, const Value& child) {
+            same = same && *key == it->first && self(self, child, it->second);
+            ++it;
+        });
+        return same;
+    };
+    if (!pair_up(pair_up, a, b)) return false;
+    std::atomic<bool> equal{true};
+    detail::steal_each_checked(pairs.size(), pool, [&](std::size_t i) {
+        if (equal.load(std::memory_order_relaxed) && *pairs[i].first != *pairs[i].second) equal = false;
+    });
+    return equal;
+}
+
+// Same as v.hash()
+inline std::size_t parallel_hash(const Value& v, ThreadPool& pool, const ParallelTreeOptions& options = {}) {
+    detail::TreePlan plan;
+    if (!detail::plan_tree(v, pool.size() + 1, options, plan)) return v.hash();
+    return detail::reduce_tree<std::size_t>(v, plan, pool,
+        [](const Value& leaf) { return leaf.hash(); },
+        [](const Value& node, std::vector<std::size_t>& children) {
+            std::size_t seed = detail::hash_container_seed(node, children.size());
+            std::size_t i = 0;
+            detail::for_each_child(node, [&](const std::string* key, const Value&) {
+                if (key) seed = detail::hash_mix(seed, std::hash<std::string_view>()(*key));
+                seed = detail::hash_mix(seed, children[i++]);
+            });
+            return seed;
+        });
+}
+
+// Same as memory_usage(v)
+inline std::size_t parallel_memory_usage(const Value& v, ThreadPool& pool, const ParallelTreeOptions& options = {}) {
+    detail::TreePlan plan;
+    if (!detail::plan_tree(v, pool.size() + 1, options, plan)) return memory_usage(v);
+    return detail::reduce_tree<std::size_t>(v, plan, pool,
+        [](const Value& leaf) { return memory_usage(leaf); },
+        [](const Value& node, std::vector<std::size_t>& children) {
+            std::size_t bytes = detail::shallow_memory_usage(node);
+            for (std::size_t child : children) bytes += child;
+            return bytes;
+        });
+}
+
+// Same as format_json(v)
+inline std::string parallel_format_json(const Value& v, ThreadPool& pool, const ParallelTreeOptions& options = {}) {
+    detail::TreePlan plan;
+    if (!detail::plan_tree(v, pool.size() + 1, options, plan)) return format_json(v);
+    return detail::reduce_tree<std::string>(v, plan, pool,
+        [](const Value& leaf) { return format_json(leaf); },
+        [](const Value& node, std::vector<std::string>& children) {
+            std::size_t size = 2;
+            for (const auto& child : children) size += child.size() + 1;
+            detail::OutputBuffer out;
+            out.str().reserve(size);
+            const bool is_map = std::holds_alternative<std::unique_ptr<Map>>(node.data);
+            out.put(is_map ? '{' : '[');
+            std::size_t i = 0;
+            detail::for_each_child(node, [&](const std::string* key, const Value&) {
+                if (i) out.put(',');
+                if (key) {
+                    detail::write_json_string(out, *key);
+                    out.put(':');
+                }
+                out.append(children[i]);
+                std::string().swap(children[i++]);
+            });
+            out.put(is_map ? '}' : ']');
+            return std::move(out.str());
+        });
+}
+
+} // namespace llsd_modern
@@ -0,0 +1,247 @@
+/**
+ * @file llsd_modern_zlib.hpp
+ * @brief Streaming gzip/zlib compression for llsd_modern.hpp.
+ *
+ * Copyright (c) 2025 humbletim
+ *
+ * This library is licensed under the MIT License.
+ *
+ * Requires zlib (link with -lz).
+ */
+#pragma once
+
+#include "llsd_modern.hpp"
+#include <zlib.h>
+
+namespace llsd_modern {
+
+// Container used for compressed output
+enum class Compression { Gzip, Zlib };
+
+// Input streambuf that inflates gzip or zlib data (detected from its header)
+// read from `src` one chunk at a time. Concatenated gzip members are read as
+// one stream. Only one chunk of compressed and one of inflated data is held.
+class InflateStreambuf : public std::streambuf {
+public:
+    explicit InflateStreambuf(std::streambuf* src, std::size_t chunk_size = 64 * 1024)
+        : src_(src), in_(chunk_size), out_(std::max(chunk_size, detail::kSniffLookahead)) {
+        zs_.zalloc = Z_NULL;
+        zs_.zfree = Z_NULL;
+        zs_.opaque = Z_NULL;
+        zs_.next_in = Z_NULL;
+        zs_.avail_in = 0;
+        if (inflateInit2(&zs_, 15 + 32) != Z_OK) throw std::runtime_error("inflateInit2 failed");
+    }
+
+    ~InflateStreambuf() override { inflateEnd(&zs_); }
+
+    InflateStreambuf(const InflateStreambuf&) = delete;
+    InflateStreambuf& operator=(const InflateStreambuf&) = delete;
+
+    // Inflated bytes that have been decoded but not yet consumed
+    std::string_view buffered() const { return std::string_view(gptr(), egptr() - gptr()); }
+
+    // Inflates until at least `n` bytes (capped at the chunk size) are
+    // buffered or the stream ends, and returns what is buffered
+    std::string_view peek(std::size_t n) {
+        n = std::min(n, out_.size());
+        while (buffered().size() < n) {
+            std::size_t have = buffered().size();
+            if (have && gptr() != out_.data()) std::memmove(out_.data(), gptr(), have);
+            std::size_t produced = inflate_into(have);
+            setg(out_.data(), out_.data(), out_.data() + have + produced);
+            if (!produced) break;
+        }
+        return buffered();
+    }
+
+protected:
+    int_type underflow() override {
+        if (gptr() < egptr()) return traits_type::to_int_type(*gptr());
+        std::size_t produced = inflate_into(0);
+        if (!produced) return traits_type::eof();
+        setg(out_.data(), out_.data(), out_.data() + produced);
+        return traits_type::to_int_type(*gptr());
+    }
+
+private:
+    // Inflates into out_ from `offset`, returning how many bytes it produced;
+    // zero only at the end of the stream
+    std::size_t inflate_into(std::size_t offset) {
+        while (!done_) {
+            if (zs_.avail_in == 0) {
+                auto n = src_->sgetn(in_.data(), static_cast<std::streamsize>(in_.size()));
+                if (n <= 0) throw std::runtime_error("Unexpected end of compressed stream");
+                zs_.next_in = reinterpret_cast<Bytef*>(in_.data());
+                zs_.avail_in = static_cast<uInt>(n);
+            }
+            zs_.next_out = reinterpret_cast<Bytef*>(out_.data() + offset);
+            zs_.avail_out = static_cast<uInt>(out_.size() - offset);
+            int ret = inflate(&zs_, Z_NO_FLUSH);
+            if (ret == Z_STREAM_END) {
+                // Another gzip member may follow
+                if (zs_.avail_in == 0 && src_->sgetc() == traits_type::eof()) {
+                    done_ = true;
+                } else {
+                    inflateReset(&zs_);
+                }
+            } else if (ret != Z_OK && ret != Z_BUF_ERROR) {
+                throw std::runtime_error(std::string("Corrupt compressed stream: ") + (zs_.msg ? zs_.msg : "inflate failed"));
+            }
+            std::size_t produced = out_.size() - offset - zs_.avail_out;
+            if (produced) return produced;
+        }
+        return 0;
+    }
+
+    std::streambuf* src_;
+    std::vector<char> in_;
+    std::vector<char> out_;
+    z_stream zs_;
+    bool done_ = false;
+};
+
+// Output streambuf that compresses everything written to it into `dst`,
+// a chunk at a time. finish() (or destruction) writes the stream trailer.
+class DeflateStreambuf : public std::streambuf {
+public:
+    explicit DeflateStreambuf(std::streambuf* dst, Compression compression = Compression::Gzip,
+                              int level = Z_DEFAULT_COMPRESSION, std::size_t chunk_size = 64 * 1024)
+        : dst_(dst), in_(chunk_size), out_(chunk_size) {
+        zs_.zalloc = Z_NULL;
+        zs_.zfree = Z_NULL;
+        zs_.opaque = Z_NULL;
+        int window_bits = compression == Compression::Gzip ? 15 + 16 : 15;
+        if (deflateInit2(&zs_, level, Z_DEFLATED, window_bits, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+            throw std::runtime_error("deflateInit2 failed");
+        }
+        setp(in_.data(), in_.data() + in_.size());
+    }
+
+    ~DeflateStreambuf() override {
+        try {
+            finish();
+        } catch (...) {
+        }
+        deflateEnd(&zs_);
+    }
+
+    DeflateStreambuf(const DeflateStreambuf&) = delete;
+    DeflateStreambuf& operator=(const DeflateStreambuf&) = delete;
+
+    // Compresses any pending input and writes the stream trailer
+    void finish() {
+        if (finished_) return;
+        deflate_pending(Z_FINISH);
+        finished_ = true;
+    }
+
+protected:
+    int_type overflow(int_type ch) override {
+        if (finished_) return traits_type::eof();
+        deflate_pending(Z_NO_FLUSH);
+        if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+            *pptr() = traits_type::to_char_type(ch);
+            pbump(1);
+        }
+        return traits_type::not_eof(ch);
+    }
+
+    int sync() override {
+        if (finished_) return 0;
+        deflate_pending(Z_SYNC_FLUSH);
+        return dst_->pubsync();
+    }
+
+private:
+    void deflate_pending(int flush) {
+        zs_.next_in = reinterpret_cast<Bytef*>(pbase());
+        zs_.avail_in = static_cast<uInt>(pptr() - pbase());
+        int ret;
+        do {
+            zs_.next_out = reinterpret_cast<Bytef*>(out_.data());
+            zs_.avail_out = static_cast<uInt>(out_.size());
+            ret = deflate(&zs_, flush);
+            if (ret == Z_STREAM_ERROR) throw std::runtime_error("deflate failed");
+            auto produced = static_cast<std::streamsize>(out_.size() - zs_.avail_out);
+            if (produced && dst_->sputn(out_.data(), produced) != produced) {
+                throw std::runtime_error("Failed writing compressed stream");
+            }
+        } while (zs_.avail_out == 0 || (flush == Z_FINISH && ret != Z_STREAM_END));
+        setp(in_.data(), in_.data() + in_.size());
+    }
+
+    std::streambuf* dst_;
+    std::vector<char> in_;
+    std::vector<char> out_;
+    z_stream zs_;
+    bool finished_ = false;
+};
+
+// Parses a gzip- or zlib-compressed LLSD document in any format parse()
+// detects, inflating it chunk by chunk. Binary and JSON are decoded straight
+// from the inflating stream, so the uncompressed text is never held whole;
+// XML, notation and compact, whose parsers scan contiguous buffers, are
+// inflated into memory first.
+inline Value parse_compressed(std::istream& in) {
+    InflateStreambuf inflater(in.rdbuf());
+    std::istream s(&inflater);
+    s.exceptions(std::ios::badbit);
+    // Skip a byte order mark and any amount of leading whitespace, so the
+    // format is sniffed from a full window of what follows however the
+    // inflated data happens to be chunked
+    std::string_view head = inflater.peek(detail::kUtf8Bom.size());
+    if (head.substr(0, detail::kUtf8Bom.size()) == detail::kUtf8Bom) s.ignore(detail::kUtf8Bom.size());
+    for (;;) {
+        head = inflater.peek(detail::kSniffLookahead);
+        if (head.empty()) throw std::runtime_error("Empty compressed stream");
+        std::size_t space = 0;
+        while (space < head.size() && detail::is_json_space(head[space])) ++space;
+        s.ignore(static_cast<std::streamsize>(space));
+        if (space < head.size()) break;
+    }
+
+    head = inflater.peek(detail::kSniffLookahead);
+    std::string_view payload = head;
+    Format format = detail::sniff_format(payload);
+    s.ignore(payload.data() - head.data());
+
+    switch (format) {
+        case Format::Binary: return parse_binary(s);
+        case Format::JSON: return parse_json(s);
+        case Format::XML:
+        case Format::Notation:
+        case Format::Compact: {
+            std::string text(std::istreambuf_iterator<char>(s), {});
+            if (format == Format::XML) return parse_xml(text);
+            if (format == Format::Notation) return parse_notation(text);
+            return detail::CompactParser(text).parse_document();
+        }
+    }
+    throw std::runtime_error("Unknown LLSD format");
+}
+
+inline Value parse_compressed(std::string_view buffer) {
+    detail::ViewStreambuf buf(buffer);
+    std::istream in(&buf);
+    return parse_compressed(in);
+}
+
+// Formats `v` as `format` (with format()'s headers) and compresses it
+// on the fly into `out`
+inline void format_compressed(std::ostream& out, const Value& v, Format format,
+                              Compression compression = Compression::Gzip, int level = Z_DEFAULT_COMPRESSION) {
+    DeflateStreambuf deflater(out.rdbuf(), compression, level);
+    std::ostream s(&deflater);
+    llsd_modern::format(s, v, format);
+    deflater.finish();
+}
+
+inline std::string format_compressed(const Value& v, Format format,
+                                     Compression compression = Compression::Gzip, int level = Z_DEFAULT_COMPRESSION) {
+    std::ostringstream out(std::ios::out | std::ios::binary);
+    format_compressed(out, v, format, compression, level);
+    return std::move(out).str();
+}
+
+} // namespace llsd_modern